@@ -0,0 +1,304 @@
+#include "alg_pag.h"
+#include "so_mem.h"
+#include "tab_pag.h"
+#include <stdlib.h>
+#include <string.h>
+
+struct alg_pag_t {
+  alg_pag_ops_t *ops;
+  so_mem_t *so_mem;
+  proc_t *dono;                  // se não for NULL, só escolhe quadros dele
+  int n_quadros;                 // número de quadros da memória
+  int ponteiro;                  // próximo quadro a examinar (relógio, NRU)
+  unsigned char *idade;          // histórico de acessos (envelhecimento)
+  unsigned semente;              // estado do gerador de números aleatórios
+};
+
+// funções auxiliares, acesso aos bits da página que está no quadro
+// um quadro compartilhado está na tabela de páginas de cada processo que o
+//   usa: a página foi acessada (ou alterada) se foi em qualquer uma delas
+static bool acessada(alg_pag_t *self, int quadro)
+{
+  int pagina = so_mem_quadro(self->so_mem, quadro).pagina;
+  for (proc_t *p = so_mem_proximo_usuario(self->so_mem, quadro, NULL);
+       p != NULL; p = so_mem_proximo_usuario(self->so_mem, quadro, p)) {
+    if (tab_pag_acessada(p->tab_pag, pagina)) return true;
+  }
+  return false;
+}
+
+static bool alterada(alg_pag_t *self, int quadro)
+{
+  int pagina = so_mem_quadro(self->so_mem, quadro).pagina;
+  for (proc_t *p = so_mem_proximo_usuario(self->so_mem, quadro, NULL);
+       p != NULL; p = so_mem_proximo_usuario(self->so_mem, quadro, p)) {
+    if (tab_pag_alterada(p->tab_pag, pagina)) return true;
+  }
+  return false;
+}
+
+static void zera_acessada(alg_pag_t *self, int quadro)
+{
+  int pagina = so_mem_quadro(self->so_mem, quadro).pagina;
+  for (proc_t *p = so_mem_proximo_usuario(self->so_mem, quadro, NULL);
+       p != NULL; p = so_mem_proximo_usuario(self->so_mem, quadro, p)) {
+    tab_pag_muda_acessada(p->tab_pag, pagina, false);
+  }
+}
+
+static int posicao(alg_pag_t *self, int quadro)
+{
+  return so_mem_quadro(self->so_mem, quadro).posicao;
+}
+
+static bool ocupado(alg_pag_t *self, int quadro)
+{
+  return !so_mem_quadro(self->so_mem, quadro).livre;
+}
+
+
+// ALEATORIO
+
+static int aleatorio_escolhe(alg_pag_t *self)
+{
+  if (self->dono == NULL) {
+    // tenta algumas vezes, pode haver quadros presos
+    for (int i = 0; i < self->n_quadros * 4; i++) {
+      int q = rand_r(&self->semente) % self->n_quadros;
+      if (alg_pag_candidato(self, q)) {
+        return q;
+      }
+    }
+  }
+  int n_cand = 0;
+  for (int q = 0; q < self->n_quadros; q++) {
+    if (alg_pag_candidato(self, q)) n_cand++;
+  }
+  if (n_cand == 0) return -1;
+  int n = rand_r(&self->semente) % n_cand;
+  for (int q = 0; q < self->n_quadros; q++) {
+    if (alg_pag_candidato(self, q) && n-- == 0) {
+      return q;
+    }
+  }
+  return -1;
+}
+
+
+// FIFO
+// so_mem mantém os quadros ocupados em ordem de carga, escolhe o primeiro
+
+static int fifo_escolhe(alg_pag_t *self)
+{
+  int q = so_mem_mais_antigo(self->so_mem);
+  while (q != -1 && !alg_pag_candidato(self, q)) {
+    q = so_mem_quadro(self->so_mem, q).prox;
+  }
+  return q;
+}
+
+
+// RELOGIO
+// percorre os quadros circularmente; uma página acessada ganha uma segunda
+//   chance (tem o bit de acesso desligado), escolhe a primeira não acessada
+
+static int relogio_escolhe(alg_pag_t *self)
+{
+  // em duas voltas, acha um quadro (se houver algum candidato)
+  for (int i = 0; i < 2 * self->n_quadros; i++) {
+    int q = self->ponteiro;
+    self->ponteiro = (self->ponteiro + 1) % self->n_quadros;
+    if (!alg_pag_candidato(self, q)) {
+      continue;
+    }
+    if (!acessada(self, q)) {
+      return q;
+    }
+    zera_acessada(self, q);
+  }
+  return -1;
+}
+
+
+// NRU
+// os bits de acesso são desligados periodicamente; escolhe uma página da
+//   menor classe: 0 não acessada nem alterada, 1 não acessada e alterada,
+//   2 acessada e não alterada, 3 acessada e alterada
+// a busca começa depois do último escolhido, para não escolher sempre os
+//   mesmos quadros
+
+static void nru_amostra(alg_pag_t *self)
+{
+  for (int q = 0; q < self->n_quadros; q++) {
+    if (ocupado(self, q) && acessada(self, q)) {
+      zera_acessada(self, q);
+    }
+  }
+}
+
+static int nru_escolhe(alg_pag_t *self)
+{
+  int escolhido = -1;
+  int menor_classe = 4;
+  for (int i = 0; i < self->n_quadros; i++) {
+    int q = (self->ponteiro + i) % self->n_quadros;
+    if (!alg_pag_candidato(self, q)) continue;
+    int classe = acessada(self, q) * 2 + alterada(self, q);
+    if (classe < menor_classe) {
+      menor_classe = classe;
+      escolhido = q;
+      if (classe == 0) break;
+    }
+  }
+  self->ponteiro = (escolhido + 1) % self->n_quadros;
+  return escolhido;
+}
+
+
+// ENVELHECIMENTO
+// a cada amostragem, o histórico de cada quadro é deslocado para a direita
+//   e recebe o bit de acesso no bit mais significativo (que é desligado);
+//   escolhe o quadro com menor histórico, contando o bit de acesso atual
+//   como o mais recente (o primeiro carregado, se empatar)
+
+static void envelhecimento_carregou(alg_pag_t *self, int quadro)
+{
+  self->idade[quadro] = 0;
+}
+
+static void envelhecimento_amostra(alg_pag_t *self)
+{
+  for (int q = 0; q < self->n_quadros; q++) {
+    if (!ocupado(self, q)) continue;
+    self->idade[q] >>= 1;
+    if (acessada(self, q)) {
+      self->idade[q] |= 0x80;
+      zera_acessada(self, q);
+    }
+  }
+}
+
+static int envelhecimento_escolhe(alg_pag_t *self)
+{
+  int escolhido = -1;
+  int menor = 0;
+  for (int q = 0; q < self->n_quadros; q++) {
+    if (!alg_pag_candidato(self, q)) continue;
+    int idade = acessada(self, q) << 8 | self->idade[q];
+    if (escolhido == -1 || idade < menor
+        || (idade == menor && posicao(self, q) < posicao(self, escolhido))) {
+      escolhido = q;
+      menor = idade;
+    }
+  }
+  return escolhido;
+}
+
+
+static alg_pag_ops_t algoritmos[N_ALG_PAG] = {
+  [ALEATORIO] = {
+    .nome = "aleatorio",
+    .escolhe = aleatorio_escolhe,
+  },
+  [FIFO] = {
+    .nome = "fifo",
+    .escolhe = fifo_escolhe,
+  },
+  [RELOGIO] = {
+    .nome = "relogio",
+    .escolhe = relogio_escolhe,
+  },
+  [NRU] = {
+    .nome = "nru",
+    .amostra = nru_amostra,
+    .escolhe = nru_escolhe,
+  },
+  [ENVELHECIMENTO] = {
+    .nome = "envelhecimento",
+    .carregou = envelhecimento_carregou,
+    .amostra = envelhecimento_amostra,
+    .escolhe = envelhecimento_escolhe,
+  },
+};
+
+alg_pag_t *alg_pag_cria(alg_pag_tipo_t tipo, so_mem_t *so_mem,
+                        unsigned semente)
+{
+  if (tipo < 0 || tipo >= N_ALG_PAG) return NULL;
+  alg_pag_t *self = malloc(sizeof(*self));
+  if (self == NULL) return NULL;
+  memset(self, 0, sizeof(*self));
+  self->ops = &algoritmos[tipo];
+  self->so_mem = so_mem;
+  self->semente = semente;
+  self->n_quadros = so_mem_num_quadros(so_mem);
+  self->idade = calloc(self->n_quadros, sizeof(unsigned char));
+  if (self->idade == NULL) {
+    free(self);
+    return NULL;
+  }
+  if (self->ops->inicia != NULL) {
+    self->ops->inicia(self);
+  }
+  for (int q = 0; q < self->n_quadros; q++) {
+    if (ocupado(self, q)) {
+      alg_pag_carregou(self, q);
+    }
+  }
+  return self;
+}
+
+void alg_pag_destroi(alg_pag_t *self)
+{
+  free(self->idade);
+  free(self);
+}
+
+void alg_pag_carregou(alg_pag_t *self, int quadro)
+{
+  if (self->ops->carregou != NULL) {
+    self->ops->carregou(self, quadro);
+  }
+}
+
+void alg_pag_amostra(alg_pag_t *self)
+{
+  if (self->ops->amostra != NULL) {
+    self->ops->amostra(self);
+  }
+}
+
+int alg_pag_escolhe(alg_pag_t *self, proc_t *dono)
+{
+  self->dono = dono;
+  int quadro = self->ops->escolhe(self);
+  self->dono = NULL;
+  return quadro;
+}
+
+bool alg_pag_candidato(alg_pag_t *self, int quadro)
+{
+  quadro_t q = so_mem_quadro(self->so_mem, quadro);
+  return !q.livre && q.presos == 0 && (self->dono == NULL || q.proc == self->dono);
+}
+
+void alg_pag_liberou(alg_pag_t *self, int quadro)
+{
+  if (self->ops->liberou != NULL) {
+    self->ops->liberou(self, quadro);
+  }
+}
+
+char *alg_pag_nome(alg_pag_tipo_t tipo)
+{
+  if (tipo < 0 || tipo >= N_ALG_PAG) return "?";
+  return algoritmos[tipo].nome;
+}
+
+alg_pag_tipo_t alg_pag_de_nome(char *nome)
+{
+  for (int t = 0; t < N_ALG_PAG; t++) {
+    if (strcmp(nome, algoritmos[t].nome) == 0) return t;
+  }
+  return N_ALG_PAG;
+}
@@ -0,0 +1,82 @@
+#ifndef ALG_PAG_H
+#define ALG_PAG_H
+
+// algoritmos de substituição de páginas
+// escolhem o quadro da memória principal que vai ser liberado quando não
+//   há quadro livre, a partir da informação dos quadros em 'so_mem' e dos
+//   bits de acesso e alteração das tabelas de páginas dos processos
+// cada algoritmo é implementado por um conjunto de funções (alg_pag_ops_t);
+//   o SO é informado dos eventos que interessam a eles através das funções
+//   alg_pag_*
+
+#include "proc.h"
+
+// os algoritmos disponíveis
+typedef enum {
+  ALEATORIO,       // escolhe uma página qualquer (péssimo)
+  FIFO,            // escolhe a página carregada há mais tempo
+  RELOGIO,         // FIFO com segunda chance para páginas acessadas
+  NRU,             // escolhe uma página da classe (acessada, alterada) mais baixa
+  ENVELHECIMENTO,  // escolhe a página com menor histórico de acessos
+  N_ALG_PAG
+} alg_pag_tipo_t;
+
+typedef struct so_mem so_mem_t;
+
+typedef struct alg_pag_t alg_pag_t;
+
+// as funções que implementam um algoritmo
+// 'carregou' é chamada quando uma página é colocada em um quadro,
+//   'amostra' periodicamente (a cada interrupção do relógio), 'escolhe'
+//   quando é necessário liberar um quadro (todos estão ocupados) e
+//   'liberou' quando um quadro é liberado sem ser escolhido (o processo
+//   terminou)
+// qualquer uma pode ser NULL, menos 'escolhe'
+// 'escolhe' só deve escolher quadros para os quais alg_pag_candidato é true
+typedef struct {
+  char *nome;
+  void (*inicia)(alg_pag_t *self);
+  void (*carregou)(alg_pag_t *self, int quadro);
+  void (*amostra)(alg_pag_t *self);
+  int (*escolhe)(alg_pag_t *self);
+  void (*liberou)(alg_pag_t *self, int quadro);
+} alg_pag_ops_t;
+
+// cria o algoritmo 'tipo', para os quadros de 'so_mem'
+// os quadros que já estiverem ocupados são considerados recém carregados
+// 'semente' inicializa o gerador de números aleatórios do algoritmo (cada
+//   algoritmo tem o seu)
+// retorna NULL em caso de erro
+alg_pag_t *alg_pag_cria(alg_pag_tipo_t tipo, so_mem_t *so_mem,
+                        unsigned semente);
+
+// destrói o algoritmo
+void alg_pag_destroi(alg_pag_t *self);
+
+// o quadro 'quadro' recebeu uma página
+void alg_pag_carregou(alg_pag_t *self, int quadro);
+
+// amostragem periódica dos bits de acesso
+void alg_pag_amostra(alg_pag_t *self);
+
+// retorna o quadro a liberar, ou -1 se não houver quadro que possa ser
+//   escolhido (estão presos)
+// se 'dono' for NULL, todos os quadros estão ocupados e qualquer um pode
+//   ser escolhido; senão, só um dos quadros do processo 'dono' pode ser
+//   escolhido (substituição local)
+int alg_pag_escolhe(alg_pag_t *self, proc_t *dono);
+
+// retorna true se o quadro pode ser escolhido pelo algoritmo na escolha
+//   em andamento
+bool alg_pag_candidato(alg_pag_t *self, int quadro);
+
+// o quadro 'quadro' foi liberado
+void alg_pag_liberou(alg_pag_t *self, int quadro);
+
+// retorna o nome do algoritmo 'tipo'
+char *alg_pag_nome(alg_pag_tipo_t tipo);
+
+// retorna o algoritmo com nome 'nome', ou N_ALG_PAG se não existir
+alg_pag_tipo_t alg_pag_de_nome(char *nome);
+
+#endif // ALG_PAG_H
@@ -0,0 +1,402 @@
+// avaliador de algoritmos de substituição de páginas
+// lê um traço de referências gravado pela MMU (teste -t, ver traco.h) e
+//   calcula, para cada número de quadros, as falhas de página que cada
+//   algoritmo teria com essas referências (substituição global, sem
+//   considerar o tempo das transferências)
+// LRU e OPT (Belady) são algoritmos de pilha: a distância de cada
+//   referência na pilha (Mattson et al., 1970) dá as falhas para todos os
+//   números de quadros de uma vez; FIFO, relógio, envelhecimento e
+//   aleatório não são, e são simulados com um conjunto de quadros para cada
+//   número de quadros, todos na mesma passada pelo traço
+
+#include "traco.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// algoritmos simulados quadro a quadro
+typedef enum {
+  SIM_FIFO,
+  SIM_RELOGIO,
+  SIM_ENVELHECIMENTO,
+  SIM_ALEATORIO,
+  N_SIM
+} sim_tipo_t;
+
+// estado de um algoritmo com um número de quadros
+typedef struct {
+  sim_tipo_t tipo;
+  int n_quadros;
+  int n_ocupados;
+  int *pagina;          // página em cada quadro
+  int *quadro;          // quadro de cada página (-1 se não está na memória)
+  bool *acessada;       // bit de acesso de cada quadro
+  unsigned char *idade; // histórico de acessos (envelhecimento)
+  long *carga;          // quando a página foi colocada no quadro
+  int ponteiro;         // próximo quadro a examinar (FIFO e relógio)
+  unsigned semente;     // estado do gerador aleatório
+  long falhas;
+} sim_t;
+
+static void uso(char *nome)
+{
+  fprintf(stderr, "uso: %s [-m quadros] [-k referências] [-n] traço\n", nome);
+  fprintf(stderr, "  -m  maior número de quadros avaliado "
+                  "(padrão: o número de páginas do traço)\n");
+  fprintf(stderr, "  -k  referências entre amostras do envelhecimento "
+                  "(padrão 100)\n");
+  fprintf(stderr, "  -n  mostra o número de falhas em vez da taxa "
+                  "(por 1000 referências)\n");
+}
+
+// ---------------------------------------------------------------------
+// leitura do traço
+
+// lê as referências do traço, coloca o tamanho das páginas em '*ptam_pag'
+//   e o número de referências em '*pn'
+// retorna NULL em caso de erro
+static traco_reg_t *le_traco(char *nome, int *ptam_pag, long *pn)
+{
+  FILE *arq = fopen(nome, "rb");
+  if (arq == NULL) {
+    perror(nome);
+    return NULL;
+  }
+  traco_cab_t cab;
+  if (fread(&cab, sizeof(cab), 1, arq) != 1 || cab.magico != TRACO_MAGICO) {
+    fprintf(stderr, "%s: não é um traço de referências\n", nome);
+    fclose(arq);
+    return NULL;
+  }
+  long cap = 1024;
+  long n = 0;
+  traco_reg_t *regs = malloc(cap * sizeof(*regs));
+  size_t lidos;
+  while ((lidos = fread(regs + n, sizeof(*regs), cap - n, arq)) > 0) {
+    n += lidos;
+    if (n == cap) {
+      cap *= 2;
+      regs = realloc(regs, cap * sizeof(*regs));
+    }
+  }
+  fclose(arq);
+  *ptam_pag = cab.tam_pag;
+  *pn = n;
+  return regs;
+}
+
+static int compara_chave(const void *a, const void *b)
+{
+  traco_reg_t x = *(const traco_reg_t *)a;
+  traco_reg_t y = *(const traco_reg_t *)b;
+  return x < y ? -1 : x > y;
+}
+
+// troca cada referência pelo número da página (de 0 ao número de páginas
+//   distintas de todos os processos) em 'ids'
+// retorna o número de páginas distintas
+static int numera_paginas(traco_reg_t *regs, long n, int *ids)
+{
+  // a chave de uma página é o registro sem o bit de escrita
+  traco_reg_t *chaves = malloc(n * sizeof(*chaves));
+  for (long i = 0; i < n; i++) {
+    chaves[i] = regs[i] | 1;
+  }
+  qsort(chaves, n, sizeof(*chaves), compara_chave);
+  int n_pags = 0;
+  for (long i = 0; i < n; i++) {
+    if (n_pags == 0 || chaves[i] != chaves[n_pags - 1]) {
+      chaves[n_pags++] = chaves[i];
+    }
+  }
+  for (long i = 0; i < n; i++) {
+    traco_reg_t chave = regs[i] | 1;
+    traco_reg_t *p = bsearch(&chave, chaves, n_pags, sizeof(*chaves),
+                             compara_chave);
+    ids[i] = p - chaves;
+  }
+  free(chaves);
+  return n_pags;
+}
+
+// ---------------------------------------------------------------------
+// algoritmos de pilha
+
+// calcula a distância de cada referência na pilha LRU e na pilha OPT,
+//   contando em 'hist_lru[d]' e 'hist_opt[d]' as referências com
+//   distância d (1 é o topo; 0 é a primeira referência à página, que é
+//   falha com qualquer número de quadros)
+// uma referência com distância d é falha com menos de d quadros
+static void distancias(int *ids, long n, int n_pags,
+                       long *hist_lru, long *hist_opt)
+{
+  // a próxima referência à mesma página (n se não houver): a prioridade
+  //   na pilha OPT é maior para a página que vai ser usada antes
+  long *prox = malloc(n * sizeof(*prox));
+  long *ultima = malloc(n_pags * sizeof(*ultima));
+  for (int p = 0; p < n_pags; p++) {
+    ultima[p] = n;
+  }
+  for (long i = n - 1; i >= 0; i--) {
+    prox[i] = ultima[ids[i]];
+    ultima[ids[i]] = i;
+  }
+  long *uso = ultima;   // próximo uso de cada página que está na pilha
+
+  int *lru = malloc(n_pags * sizeof(*lru));
+  int *opt = malloc(n_pags * sizeof(*opt));
+  int tam = 0;          // as duas pilhas têm as mesmas páginas
+  for (long i = 0; i < n; i++) {
+    int pag = ids[i];
+
+    int d = 0;
+    while (d < tam && lru[d] != pag) d++;
+    if (d == tam) {
+      hist_lru[0]++;
+    } else {
+      hist_lru[d + 1]++;
+    }
+    memmove(lru + 1, lru, (d < tam ? d : tam) * sizeof(*lru));
+    lru[0] = pag;
+
+    // a página referenciada vai para o topo; descendo até onde ela
+    //   estava, em cada posição fica a de maior prioridade entre a que
+    //   estava lá e a que desceu da posição anterior
+    d = 0;
+    while (d < tam && opt[d] != pag) d++;
+    if (d == tam) {
+      hist_opt[0]++;
+    } else {
+      hist_opt[d + 1]++;
+    }
+    if (d > 0) {
+      int desce = opt[0];
+      for (int k = 1; k < d; k++) {
+        if (uso[opt[k]] > uso[desce]) {
+          int t = opt[k];
+          opt[k] = desce;
+          desce = t;
+        }
+      }
+      opt[d] = desce;
+    }
+    opt[0] = pag;
+    uso[pag] = prox[i];
+    if (d == tam) tam++;
+  }
+  free(prox);
+  free(ultima);
+  free(lru);
+  free(opt);
+}
+
+// ---------------------------------------------------------------------
+// algoritmos simulados
+
+static void sim_inicia(sim_t *self, sim_tipo_t tipo, int n_quadros,
+                       int n_pags)
+{
+  self->tipo = tipo;
+  self->n_quadros = n_quadros;
+  self->n_ocupados = 0;
+  self->pagina = malloc(n_quadros * sizeof(*self->pagina));
+  self->acessada = malloc(n_quadros * sizeof(*self->acessada));
+  self->idade = malloc(n_quadros * sizeof(*self->idade));
+  self->carga = malloc(n_quadros * sizeof(*self->carga));
+  self->quadro = malloc(n_pags * sizeof(*self->quadro));
+  for (int p = 0; p < n_pags; p++) {
+    self->quadro[p] = -1;
+  }
+  self->ponteiro = 0;
+  self->semente = 42;
+  self->falhas = 0;
+}
+
+static void sim_termina(sim_t *self)
+{
+  free(self->pagina);
+  free(self->acessada);
+  free(self->idade);
+  free(self->carga);
+  free(self->quadro);
+}
+
+// amostra os bits de acesso (interrupção de relógio do envelhecimento)
+static void sim_amostra(sim_t *self)
+{
+  for (int q = 0; q < self->n_ocupados; q++) {
+    self->idade[q] >>= 1;
+    if (self->acessada[q]) {
+      self->idade[q] |= 0x80;
+      self->acessada[q] = false;
+    }
+  }
+}
+
+// escolhe o quadro cuja página vai ser substituída (todos estão ocupados)
+static int sim_escolhe(sim_t *self)
+{
+  int q;
+  switch (self->tipo) {
+    case SIM_FIFO:
+      q = self->ponteiro;
+      self->ponteiro = (q + 1) % self->n_quadros;
+      return q;
+    case SIM_RELOGIO:
+      while (self->acessada[self->ponteiro]) {
+        self->acessada[self->ponteiro] = false;
+        self->ponteiro = (self->ponteiro + 1) % self->n_quadros;
+      }
+      q = self->ponteiro;
+      self->ponteiro = (q + 1) % self->n_quadros;
+      return q;
+    case SIM_ENVELHECIMENTO: {
+      // como em alg_pag.c: o menor histórico, com o bit de acesso atual
+      //   acima dele; no empate, a página carregada antes
+      int escolhido = 0;
+      int menor = self->acessada[0] << 8 | self->idade[0];
+      for (q = 1; q < self->n_quadros; q++) {
+        int idade = self->acessada[q] << 8 | self->idade[q];
+        if (idade < menor
+            || (idade == menor && self->carga[q] < self->carga[escolhido])) {
+          escolhido = q;
+          menor = idade;
+        }
+      }
+      return escolhido;
+    }
+    default:
+      self->semente = self->semente * 1103515245 + 12345;
+      return (self->semente >> 16) % self->n_quadros;
+  }
+}
+
+static void sim_referencia(sim_t *self, int pag, long agora)
+{
+  int q = self->quadro[pag];
+  if (q != -1) {
+    self->acessada[q] = true;
+    return;
+  }
+  self->falhas++;
+  if (self->n_ocupados < self->n_quadros) {
+    q = self->n_ocupados++;
+  } else {
+    q = sim_escolhe(self);
+    self->quadro[self->pagina[q]] = -1;
+  }
+  self->pagina[q] = pag;
+  self->quadro[pag] = q;
+  self->acessada[q] = true;
+  self->idade[q] = 0;
+  self->carga[q] = agora;
+}
+
+// ---------------------------------------------------------------------
+
+int main(int argc, char *argv[])
+{
+  int max_quadros = 0;
+  int periodo = 100;
+  bool mostra_falhas = false;
+  int opt;
+  while ((opt = getopt(argc, argv, "m:k:n")) != -1) {
+    switch (opt) {
+      case 'm':
+        max_quadros = atoi(optarg);
+        break;
+      case 'k':
+        periodo = atoi(optarg);
+        break;
+      case 'n':
+        mostra_falhas = true;
+        break;
+      default:
+        uso(argv[0]);
+        return 1;
+    }
+  }
+  if (optind != argc - 1 || max_quadros < 0 || periodo < 1) {
+    uso(argv[0]);
+    return 1;
+  }
+
+  int tam_pag;
+  long n;
+  traco_reg_t *regs = le_traco(argv[optind], &tam_pag, &n);
+  if (regs == NULL) return 1;
+  int *ids = malloc((n > 0 ? n : 1) * sizeof(*ids));
+  int n_pags = numera_paginas(regs, n, ids);
+  long escritas = 0;
+  for (long i = 0; i < n; i++) {
+    escritas += traco_escrita(regs[i]);
+  }
+  free(regs);
+  if (max_quadros == 0 || max_quadros > n_pags) max_quadros = n_pags;
+
+  long *hist_lru = calloc(n_pags + 1, sizeof(*hist_lru));
+  long *hist_opt = calloc(n_pags + 1, sizeof(*hist_opt));
+  distancias(ids, n, n_pags, hist_lru, hist_opt);
+
+  // uma simulação de cada algoritmo para cada número de quadros
+  sim_t *sims = malloc(N_SIM * (max_quadros + 1) * sizeof(*sims));
+  for (int t = 0; t < N_SIM; t++) {
+    for (int m = 1; m <= max_quadros; m++) {
+      sim_inicia(&sims[t * (max_quadros + 1) + m], t, m, n_pags);
+    }
+  }
+  for (long i = 0; i < n; i++) {
+    for (int t = 0; t < N_SIM; t++) {
+      for (int m = 1; m <= max_quadros; m++) {
+        sim_t *sim = &sims[t * (max_quadros + 1) + m];
+        if (t == SIM_ENVELHECIMENTO && i % periodo == 0) sim_amostra(sim);
+        sim_referencia(sim, ids[i], i);
+      }
+    }
+  }
+
+  printf("Referências: %ld (%ld escritas)\n", n, escritas);
+  printf("Páginas distintas: %d\n", n_pags);
+  printf("Tamanho das páginas: %d\n", tam_pag);
+  printf("%s\n", mostra_falhas ? "Falhas de página"
+                               : "Falhas de página por 1000 referências");
+  // (os nomes com acento têm um byte a mais)
+  printf("%7s %7s %9s %10s %9s %9s %10s %9s\n", "quadros", "MEM_TAM",
+         "FIFO", "relógio", "LRU", "envelhec.", "aleatório", "OPT");
+  // falhas com m quadros: referências com distância 0 ou maior que m
+  long falhas_lru = n;
+  long falhas_opt = n;
+  for (int m = 1; m <= max_quadros; m++) {
+    falhas_lru -= hist_lru[m];
+    falhas_opt -= hist_opt[m];
+    long falhas[] = {
+      sims[SIM_FIFO * (max_quadros + 1) + m].falhas,
+      sims[SIM_RELOGIO * (max_quadros + 1) + m].falhas,
+      falhas_lru,
+      sims[SIM_ENVELHECIMENTO * (max_quadros + 1) + m].falhas,
+      sims[SIM_ALEATORIO * (max_quadros + 1) + m].falhas,
+      falhas_opt,
+    };
+    printf("%7d %7d", m, m * tam_pag);
+    for (int a = 0; a < sizeof(falhas) / sizeof(falhas[0]); a++) {
+      if (mostra_falhas) {
+        printf(" %9ld", falhas[a]);
+      } else {
+        printf(" %9.1f", n > 0 ? 1000.0 * falhas[a] / n : 0.0);
+      }
+    }
+    printf("\n");
+  }
+
+  for (int t = 0; t < N_SIM; t++) {
+    for (int m = 1; m <= max_quadros; m++) {
+      sim_termina(&sims[t * (max_quadros + 1) + m]);
+    }
+  }
+  free(sims);
+  free(hist_lru);
+  free(hist_opt);
+  free(ids);
+  return 0;
+}
@@ -0,0 +1,296 @@
+#include "config.h"
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+
+// valores padrão, usados quando não são alterados na execução
+#define MEM_TAM 300 // tamanho da memória principal
+#define QUADRO_TAM 50
+#define PERIODO_RELOGIO 16
+#define PROGRAMA_INICIAL 0
+#define ESCALONADOR ROUND_ROBIN
+#define MAX_QUANTUM 2
+#define ALG_PAG FIFO
+#define SUBST SUBST_GLOBAL
+#define FALPAG_ASSINCRONA false
+#define COTA_MIN 3 // uma instrução pode acessar até 3 páginas
+#define CONTROLE_CARGA false
+#define JANELA_PFF 4
+#define PFF_ALTA 2
+#define PFF_BAIXA 1
+#define DEMANDA_MIN 2
+#define LIMPEZA false
+#define LIMPOS_MIN 2
+#define PREBUSCA_SEQ 0
+#define PRE_PAGINACAO false
+#define COMPARTILHA false
+#define MAX_PAGINAS 1024
+#define METRICAS "./metricas"
+
+// tamanho máximo de uma linha do arquivo de configuração
+#define LINHA_TAM 200
+
+// nomes dos valores dos parâmetros que não são números
+static char *nome_motor[] = {
+  [EXEC_SWITCH] = "switch",
+  [EXEC_ENCADEADO] = "encadeado",
+  [EXEC_JIT] = "jit",
+};
+static char *nome_escalonador[] = {
+  [ROUND_ROBIN] = "round_robin",
+  [SHORTEST] = "shortest",
+};
+static char *nome_bool[] = {
+  [false] = "nao",
+  [true] = "sim",
+};
+static char *nome_subst[] = {
+  [SUBST_GLOBAL] = "global",
+  [SUBST_LOCAL_IGUAL] = "igual",
+  [SUBST_LOCAL_PROPORCIONAL] = "proporcional",
+  [SUBST_LOCAL_PFF] = "pff",
+};
+
+#define N_NOMES(v) (int)(sizeof(v)/sizeof(v[0]))
+
+void config_padrao(config_t *self)
+{
+  self->mem_tam = MEM_TAM;
+  self->quadro_tam = QUADRO_TAM;
+  self->periodo_relogio = PERIODO_RELOGIO;
+  self->motor = EXEC_MOTOR;
+  self->programa_inicial = PROGRAMA_INICIAL;
+  self->escalonador = ESCALONADOR;
+  self->max_quantum = MAX_QUANTUM;
+  self->alg_pag = ALG_PAG;
+  self->subst = SUBST;
+  self->falpag_assincrona = FALPAG_ASSINCRONA;
+  self->cota_min = COTA_MIN;
+  self->controle_carga = CONTROLE_CARGA;
+  self->janela_pff = JANELA_PFF;
+  self->pff_alta = PFF_ALTA;
+  self->pff_baixa = PFF_BAIXA;
+  self->demanda_min = DEMANDA_MIN;
+  self->limpeza = LIMPEZA;
+  self->limpos_min = LIMPOS_MIN;
+  self->prebusca_seq = PREBUSCA_SEQ;
+  self->pre_paginacao = PRE_PAGINACAO;
+  self->compartilha = COMPARTILHA;
+  self->max_paginas = MAX_PAGINAS;
+  self->semente = time(NULL);
+  strcpy(self->metricas, METRICAS);
+  self->console[0] = '\0';
+}
+
+// funções auxiliares, convertem 'valor' em '*pv'; retornam false se não der
+static bool le_inteiro(char *valor, int min, int *pv)
+{
+  char *fim;
+  long v = strtol(valor, &fim, 10);
+  if (fim == valor || *fim != '\0' || v < min || v > 1000000000) return false;
+  *pv = v;
+  return true;
+}
+
+static bool le_texto(char *valor, char *v)
+{
+  if (strlen(valor) >= CONFIG_NOME_TAM) return false;
+  strcpy(v, valor);
+  return true;
+}
+
+static bool le_nome(char *valor, char *nomes[], int n, int *pv)
+{
+  for (int i = 0; i < n; i++) {
+    if (strcmp(valor, nomes[i]) == 0) {
+      *pv = i;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool config_muda(config_t *self, char *chave, char *valor)
+{
+  int v;
+  if (strcmp(chave, "mem_tam") == 0) {
+    if (!le_inteiro(valor, 1, &v)) return false;
+    self->mem_tam = v;
+  } else if (strcmp(chave, "quadro_tam") == 0) {
+    if (!le_inteiro(valor, 1, &v)) return false;
+    self->quadro_tam = v;
+  } else if (strcmp(chave, "periodo_relogio") == 0) {
+    if (!le_inteiro(valor, 1, &v)) return false;
+    self->periodo_relogio = v;
+  } else if (strcmp(chave, "motor") == 0) {
+    if (!le_nome(valor, nome_motor, N_NOMES(nome_motor), &v)) return false;
+    self->motor = v;
+  } else if (strcmp(chave, "programa_inicial") == 0) {
+    if (!le_inteiro(valor, 0, &v)) return false;
+    self->programa_inicial = v;
+  } else if (strcmp(chave, "escalonador") == 0) {
+    if (!le_nome(valor, nome_escalonador, N_NOMES(nome_escalonador), &v)) {
+      return false;
+    }
+    self->escalonador = v;
+  } else if (strcmp(chave, "max_quantum") == 0) {
+    if (!le_inteiro(valor, 1, &v)) return false;
+    self->max_quantum = v;
+  } else if (strcmp(chave, "alg_pag") == 0) {
+    v = alg_pag_de_nome(valor);
+    if (v == N_ALG_PAG) return false;
+    self->alg_pag = v;
+  } else if (strcmp(chave, "subst") == 0) {
+    if (!le_nome(valor, nome_subst, N_NOMES(nome_subst), &v)) return false;
+    self->subst = v;
+  } else if (strcmp(chave, "falpag_assincrona") == 0) {
+    if (!le_nome(valor, nome_bool, N_NOMES(nome_bool), &v)) return false;
+    self->falpag_assincrona = v;
+  } else if (strcmp(chave, "cota_min") == 0) {
+    if (!le_inteiro(valor, 1, &v)) return false;
+    self->cota_min = v;
+  } else if (strcmp(chave, "controle_carga") == 0) {
+    if (!le_nome(valor, nome_bool, N_NOMES(nome_bool), &v)) return false;
+    self->controle_carga = v;
+  } else if (strcmp(chave, "janela_pff") == 0) {
+    if (!le_inteiro(valor, 1, &v)) return false;
+    self->janela_pff = v;
+  } else if (strcmp(chave, "pff_alta") == 0) {
+    if (!le_inteiro(valor, 0, &v)) return false;
+    self->pff_alta = v;
+  } else if (strcmp(chave, "pff_baixa") == 0) {
+    if (!le_inteiro(valor, 0, &v)) return false;
+    self->pff_baixa = v;
+  } else if (strcmp(chave, "demanda_min") == 0) {
+    if (!le_inteiro(valor, 1, &v)) return false;
+    self->demanda_min = v;
+  } else if (strcmp(chave, "limpeza") == 0) {
+    if (!le_nome(valor, nome_bool, N_NOMES(nome_bool), &v)) return false;
+    self->limpeza = v;
+  } else if (strcmp(chave, "limpos_min") == 0) {
+    if (!le_inteiro(valor, 0, &v)) return false;
+    self->limpos_min = v;
+  } else if (strcmp(chave, "prebusca_seq") == 0) {
+    if (!le_inteiro(valor, 0, &v)) return false;
+    self->prebusca_seq = v;
+  } else if (strcmp(chave, "pre_paginacao") == 0) {
+    if (!le_nome(valor, nome_bool, N_NOMES(nome_bool), &v)) return false;
+    self->pre_paginacao = v;
+  } else if (strcmp(chave, "compartilha") == 0) {
+    if (!le_nome(valor, nome_bool, N_NOMES(nome_bool), &v)) return false;
+    self->compartilha = v;
+  } else if (strcmp(chave, "max_paginas") == 0) {
+    if (!le_inteiro(valor, 1, &v)) return false;
+    self->max_paginas = v;
+  } else if (strcmp(chave, "semente") == 0) {
+    if (!le_inteiro(valor, 0, &v)) return false;
+    self->semente = v;
+  } else if (strcmp(chave, "metricas") == 0) {
+    if (!le_texto(valor, self->metricas)) return false;
+  } else if (strcmp(chave, "console") == 0) {
+    if (!le_texto(valor, self->console)) return false;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+// função auxiliar, tira os espaços do início e do fim de 's'
+static char *apara(char *s)
+{
+  while (isspace((unsigned char)*s)) s++;
+  char *fim = s + strlen(s);
+  while (fim > s && isspace((unsigned char)fim[-1])) fim--;
+  *fim = '\0';
+  return s;
+}
+
+bool config_muda_par(config_t *self, char *par)
+{
+  char *igual = strchr(par, '=');
+  if (igual == NULL) return false;
+  *igual = '\0';
+  bool ok = config_muda(self, apara(par), apara(igual + 1));
+  *igual = '=';
+  return ok;
+}
+
+bool config_le_arquivo(config_t *self, char *nome)
+{
+  FILE *arq = fopen(nome, "r");
+  if (arq == NULL) {
+    perror(nome);
+    return false;
+  }
+  char linha[LINHA_TAM];
+  int n_linha = 0;
+  bool ok = true;
+  while (ok && fgets(linha, sizeof(linha), arq) != NULL) {
+    n_linha++;
+    char *comentario = strchr(linha, '#');
+    if (comentario != NULL) *comentario = '\0';
+    char *par = apara(linha);
+    if (*par == '\0') continue;
+    if (!config_muda_par(self, par)) {
+      fprintf(stderr, "%s:%d: parâmetro inválido: %s\n", nome, n_linha, par);
+      ok = false;
+    }
+  }
+  fclose(arq);
+  return ok;
+}
+
+char *config_erro(config_t *self)
+{
+  if (self->mem_tam % self->quadro_tam != 0) {
+    return "mem_tam deve ser múltiplo de quadro_tam";
+  }
+  if (self->mem_tam / self->quadro_tam < 3) {
+    return "a memória deve ter pelo menos 3 quadros";
+  }
+  if (self->cota_min > config_num_quadros(self)) {
+    return "cota_min não pode ser maior que o número de quadros";
+  }
+  if (self->demanda_min > config_num_quadros(self)) {
+    return "demanda_min não pode ser maior que o número de quadros";
+  }
+  if (self->pff_baixa > self->pff_alta) {
+    return "pff_baixa não pode ser maior que pff_alta";
+  }
+  return NULL;
+}
+
+int config_num_quadros(config_t *self)
+{
+  return self->mem_tam / self->quadro_tam;
+}
+
+void config_imprime(config_t *self, FILE *arq)
+{
+  fprintf(arq, "mem_tam = %d\n", self->mem_tam);
+  fprintf(arq, "quadro_tam = %d\n", self->quadro_tam);
+  fprintf(arq, "periodo_relogio = %d\n", self->periodo_relogio);
+  fprintf(arq, "motor = %s\n", nome_motor[self->motor]);
+  fprintf(arq, "programa_inicial = %d\n", self->programa_inicial);
+  fprintf(arq, "escalonador = %s\n", nome_escalonador[self->escalonador]);
+  fprintf(arq, "max_quantum = %d\n", self->max_quantum);
+  fprintf(arq, "alg_pag = %s\n", alg_pag_nome(self->alg_pag));
+  fprintf(arq, "subst = %s\n", nome_subst[self->subst]);
+  fprintf(arq, "falpag_assincrona = %s\n", nome_bool[self->falpag_assincrona]);
+  fprintf(arq, "cota_min = %d\n", self->cota_min);
+  fprintf(arq, "controle_carga = %s\n", nome_bool[self->controle_carga]);
+  fprintf(arq, "janela_pff = %d\n", self->janela_pff);
+  fprintf(arq, "pff_alta = %d\n", self->pff_alta);
+  fprintf(arq, "pff_baixa = %d\n", self->pff_baixa);
+  fprintf(arq, "demanda_min = %d\n", self->demanda_min);
+  fprintf(arq, "limpeza = %s\n", nome_bool[self->limpeza]);
+  fprintf(arq, "limpos_min = %d\n", self->limpos_min);
+  fprintf(arq, "prebusca_seq = %d\n", self->prebusca_seq);
+  fprintf(arq, "pre_paginacao = %s\n", nome_bool[self->pre_paginacao]);
+  fprintf(arq, "compartilha = %s\n", nome_bool[self->compartilha]);
+  fprintf(arq, "max_paginas = %d\n", self->max_paginas);
+  fprintf(arq, "semente = %u\n", self->semente);
+  fprintf(arq, "metricas = %s\n", self->metricas);
+  fprintf(arq, "console = %s\n", self->console);
+}
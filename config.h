@@ -0,0 +1,86 @@
+#ifndef CONFIG_H
+#define CONFIG_H
+
+// config
+// parâmetros da simulação que podem ser escolhidos na execução, sem
+//   recompilar: o tamanho da memória e dos quadros, o período do relógio, o
+//   motor de execução e a semente dos números aleatórios (hardware), o
+//   escalonador, o quantum, a substituição de páginas, os parâmetros da
+//   paginação e o programa inicial (SO), e onde ficam os resultados
+// os parâmetros podem ser alterados um a um pelo nome ("chave=valor") ou
+//   lidos de um arquivo, com uma linha "chave = valor" para cada um (o que
+//   vem depois de '#' é comentário)
+
+#include "exec.h"
+#include "alg_pag.h"
+#include "so.h"
+#include <stdbool.h>
+#include <stdio.h>
+
+// tamanho máximo dos nomes de arquivos e diretórios
+#define CONFIG_NOME_TAM 256
+
+struct config_t {
+  int mem_tam;                // tamanho da memória principal, em palavras
+  int quadro_tam;             // tamanho das páginas e quadros, em palavras
+  int periodo_relogio;        // instruções entre interrupções do relógio
+  exec_motor_t motor;         // motor de execução de instruções
+  int programa_inicial;       // programa do primeiro processo
+  escalonador_t escalonador;  // escalonador de processos
+  int max_quantum;            // interrupções de relógio por quantum
+  alg_pag_tipo_t alg_pag;     // algoritmo de substituição de páginas
+  so_subst_t subst;           // alcance da substituição de páginas
+  bool falpag_assincrona;     // o processo espera o disco numa falha de
+                              //   página (senão a transferência é imediata)
+  int cota_min;               // menor cota de quadros na substituição local
+  bool controle_carga;        // suspende processos quando a demanda de
+                              //   quadros estimada passa da memória
+  int janela_pff;             // interrupções de relógio por janela de
+                              //   medida das falhas de página
+  int pff_alta;               // com mais falhas na janela, a demanda cresce
+  int pff_baixa;              // com menos falhas na janela, a demanda cai
+  int demanda_min;            // menor demanda de quadros estimada
+  bool limpeza;               // copia em segundo plano as páginas alteradas
+                              //   que serão substituídas logo
+  int limpos_min;             // quadros livres ou limpos que a limpeza mantém
+  int prebusca_seq;           // páginas trazidas a mais numa falha em
+                              //   acesso sequencial (0 desliga)
+  bool pre_paginacao;         // um processo suspenso volta com as páginas
+                              //   que tinha na memória
+  bool compartilha;           // páginas não alteradas de mesmo conteúdo
+                              //   usam o mesmo quadro (copy-on-write)
+  int max_paginas;            // páginas do espaço de endereçamento de um
+                              //   processo (ou as do programa, se mais)
+  unsigned semente;           // semente dos geradores de números aleatórios
+  char metricas[CONFIG_NOME_TAM]; // diretório onde são escritas as métricas
+  char console[CONFIG_NOME_TAM];  // arquivo da console da tela sem
+                                  //   interface ("" para a saída padrão)
+};
+
+// preenche a configuração com os valores padrão (a semente vem da hora)
+void config_padrao(config_t *self);
+
+// altera o parâmetro de nome 'chave' para o descrito em 'valor'
+// retorna false (sem alterar nada) se não houver o parâmetro ou o valor
+//   não for válido para ele
+bool config_muda(config_t *self, char *chave, char *valor);
+
+// altera o parâmetro descrito por "chave=valor"
+bool config_muda_par(config_t *self, char *par);
+
+// altera os parâmetros descritos no arquivo 'nome'
+// retorna false se o arquivo não puder ser lido ou tiver uma linha inválida
+//   (e informa o problema em stderr)
+bool config_le_arquivo(config_t *self, char *nome);
+
+// verifica se os parâmetros são coerentes entre si
+// retorna uma descrição do problema, ou NULL se estiverem
+char *config_erro(config_t *self);
+
+// número de quadros da memória principal
+int config_num_quadros(config_t *self);
+
+// escreve os parâmetros em 'arq', no formato lido por config_le_arquivo
+void config_imprime(config_t *self, FILE *arq);
+
+#endif // CONFIG_H
@@ -8,13 +8,22 @@
 #include "tela.h"
 #include "instr.h"
 #include "rand.h"
+#include "swap.h"
 #include "mmu.h"
+#include "config.h"
 
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
 
+// número máximo de instruções executadas sem voltar ao laço principal
+//   (o lote também termina no próximo tic do relógio)
+#define LOTE_MAX 1000
 
+// tempo de cada pedido ao disco de paginação: um tempo de acesso fixo, mais
+//   um tempo de transferência por página
+#define SWAP_TEMPO_ACESSO 40
+#define SWAP_TEMPO_TRANSF 10
 
 struct contr_t {
   mem_t *mem;
@@ -25,24 +34,28 @@ struct contr_t {
   es_t *es;
   so_t *so;
   rand_t *rand;
+  swap_t *swap;
+  tela_t *tela;
 };
 
 // funções auxiliares
 static void contr_atualiza_estado(contr_t *self);
+static void str_estado(char *txt, int tam, exec_t *exec, mmu_t *mmu, so_t* so);
 
 
-contr_t *contr_cria(void)
+contr_t *contr_cria(config_t *config)
 {
   contr_t *self = malloc(sizeof(*self));
   if (self == NULL) return NULL;
   // cria a memória e a MMU
-  self->mem = mem_cria(MEM_TAM);
+  self->mem = mem_cria(config->mem_tam);
   self->mmu = mmu_cria(self->mem);
   // cria dispositivos de E/S (o relógio e um terminal)
-  self->term = term_cria();
-  self->rel = rel_cria(16);
-  self->rand = rand_cria(self->rel);
-  t_inicio();
+  self->tela = t_inicio(config->console[0] != '\0' ? config->console : NULL);
+  self->term = term_cria(self->tela);
+  self->rel = rel_cria(config->periodo_relogio);
+  self->rand = rand_cria(self->rel, config->semente);
+  self->swap = swap_cria(self->rel, SWAP_TEMPO_ACESSO, SWAP_TEMPO_TRANSF);
   // cria o controlador de E/S e registra os dispositivos
   self->es = es_cria();
   for (int t=0; t<8; t++) { // Registra os 8 terminais
@@ -51,8 +64,10 @@ contr_t *contr_cria(void)
   es_registra_dispositivo(self->es, 8, self->rel, 0, rel_le, NULL, NULL);
   es_registra_dispositivo(self->es, 9, self->rel, 1, rel_le, NULL, NULL);
   es_registra_dispositivo(self->es, 10, self->rand, 0, rand_le, NULL, rand_pronto);
+  es_registra_dispositivo(self->es, SWAP_DISP, self->swap, 0, swap_le, swap_escr, swap_pronto);
   // cria a unidade de execução e inicializa com a mmu e E/S
   self->exec = exec_cria(self->mmu, self->es);
+  exec_muda_motor(self->exec, config->motor);
   self->so = NULL;
   return self;
 }
@@ -64,10 +79,11 @@ void contr_destroi(contr_t *self)
   es_destroi(self->es);
   term_destroi(self->term);
   rel_destroi(self->rel);
-  t_fim();
+  t_fim(self->tela);
   mem_destroi(self->mem);
   mmu_destroi(self->mmu);
   rand_destroi(self->rand);
+  swap_destroi(self->swap);
   free(self);
 }
 
@@ -101,59 +117,77 @@ es_t *contr_es(contr_t *self)
   return self->es;
 }
 
+tela_t *contr_tela(contr_t *self)
+{
+  return self->tela;
+}
+
 void contr_laco(contr_t *self)
 {
-  // executa uma instrução por vez até SO dizer que chega
+  // executa as instruções em lotes até SO dizer que chega
+  // cada lote vai no máximo até o próximo tic do relógio, e termina antes
+  //   se alguma instrução causar interrupção; o resultado é o mesmo de
+  //   executar uma instrução por vez, com o relógio avançando a cada uma
   do {
     err_t err;
-    err = exec_executa_1(self->exec);
+    int limite = rel_falta_tic(self->rel);
+    if (limite == 0 || limite > LOTE_MAX) limite = LOTE_MAX;
+    if (t_passo_a_passo(self->tela)) limite = 1;
+    int feitas;
+    err = exec_executa_n(self->exec, limite, &feitas);
+    // as instruções antes da última do lote não causaram interrupção
+    rel_avanca(self->rel, feitas - 1);
     if (err != ERR_OK) so_int(self->so, err);
     err = rel_tictac(self->rel);
     if (err != ERR_OK && so_ok(self->so)) so_int(self->so, err);
     contr_atualiza_estado(self);
-    t_atualiza();
+    t_atualiza(self->tela);
   } while (so_ok(self->so));
+  // o último estado é sempre mostrado
+  char s[N_COL+1];
+  str_estado(s, sizeof(s), self->exec, self->mmu, self->so);
+  t_status(self->tela, s);
       
-  t_printf("Fim da execução.");
-  t_printf("relógio: %d\n", rel_agora(self->rel));
+  t_printf(self->tela, "Fim da execução.");
+  t_printf(self->tela, "relógio: %d\n", rel_agora(self->rel));
 }
  
 
-static void str_estado(char *txt, exec_t *exec, mmu_t *mmu, so_t* so)
+static void str_estado(char *txt, int tam, exec_t *exec, mmu_t *mmu, so_t* so)
 {
   // pega o estado da CPU, imprime registradores, opcode, instrução
   cpu_estado_t *estado = cpue_cria();
   exec_copia_estado(exec, estado);
   if (cpue_modo(estado) == zumbi) {
-    sprintf(txt, "zumbi");
+    snprintf(txt, tam, "zumbi");
+    cpue_destroi(estado);
     return;
   }
   int pc, opcode = -1;
   pc = cpue_PC(estado);
-  mmu_le(mmu, pc, &opcode);
-  sprintf(txt, "PID=%d PC=%04d A=%06d X=%06d %02d %s", so_pid(so),
-                pc, cpue_A(estado), cpue_X(estado), opcode, instr_nome(opcode));
+  mmu_espia(mmu, pc, &opcode);
+  // n é quanto já foi escrito em txt; o que não cabe na linha é cortado
+  int n = snprintf(txt, tam, "PID=%d PC=%04d A=%06d X=%06d %02d %s", so_pid(so),
+                   pc, cpue_A(estado), cpue_X(estado), opcode, instr_nome(opcode));
   // imprime argumento da instrução, se houver
-  if (instr_num_args(opcode) > 0) {
-    char aux[40];
+  if (instr_num_args(opcode) > 0 && n >= 0 && n < tam) {
     int A1;
-    mmu_le(mmu, pc+1, &A1);
-    sprintf(aux, " %d", A1);
-    strcat(txt, aux);
+    mmu_espia(mmu, pc+1, &A1);
+    n += snprintf(txt + n, tam - n, " %d", A1);
   }
   // imprime estado de erro da CPU, se for o caso
   err_t err = cpue_erro(estado);
-  if (err != ERR_OK) {
-    char aux[40];
-    sprintf(aux, " E=%d(%d) %s", err, cpue_complemento(estado), err_nome(err));
-    strcat(txt, aux);
+  if (err != ERR_OK && n >= 0 && n < tam) {
+    snprintf(txt + n, tam - n, " E=%d(%d) %s", err, cpue_complemento(estado), err_nome(err));
   }
   cpue_destroi(estado);
 }
 
 void contr_atualiza_estado(contr_t *self)
 {
+  // só monta o texto se ele for ser mostrado
+  if (!t_quer_status(self->tela)) return;
   char s[N_COL+1];
-  str_estado(s, self->exec, self->mmu, self->so);
-  t_status(s);
+  str_estado(s, sizeof(s), self->exec, self->mmu, self->so);
+  t_status(self->tela, s);
 }
@@ -8,6 +8,7 @@
 // concentra os dispositivos de hardware
 
 typedef struct contr_t contr_t;
+typedef struct config_t config_t;
 
 #include "so_mem.h"
 #include "mem.h"
@@ -15,8 +16,14 @@ typedef struct contr_t contr_t;
 #include "so.h"
 #include "exec.h"
 #include "rel.h"
-
-contr_t *contr_cria(void);
+#include "tela.h"
+
+// cria o hardware, com os parâmetros de 'config' (o tamanho da memória, o
+//   período do relógio, o motor de execução, a semente do gerador de números
+//   aleatórios e onde a tela escreve a console)
+// cada controlador tem seu próprio estado, vários podem executar ao mesmo
+//   tempo (em threads diferentes), desde que com a tela sem interface
+contr_t *contr_cria(config_t *config);
 void contr_destroi(contr_t *self);
 
 // o laço principal da simulação
@@ -31,5 +38,6 @@ mmu_t *contr_mmu(contr_t *self);
 rel_t *contr_rel(contr_t *self);
 exec_t *contr_exec(contr_t *self);
 es_t *contr_es(contr_t *self);
+tela_t *contr_tela(contr_t *self);
 
 #endif // CONTR_H
@@ -3,11 +3,31 @@
 
 #include "exec.h"
 #include "instr.h"
+#include "jit.h"
+
+// instrução pré-decodificada
+// existe uma entrada para cada endereço da memória física, preenchida na
+//   primeira vez que uma instrução é buscada nesse endereço e invalidada
+//   quando esse endereço (ou o do argumento) é alterado
+typedef struct {
+  bool valida;  // a entrada corresponde ao conteúdo atual da memória
+  bool tem_A1;  // o argumento foi decodificado junto (está na mesma página)
+  int opcode;
+  int A1;
+} decod_t;
+
 // uma CPU tem estado, gerenciador de memória, controlador de ES
 struct exec_t {
   cpu_estado_t *estado;
   mmu_t *mmu;
   es_t *es;
+  exec_motor_t motor;  // como as instruções são despachadas
+  jit_t *jit;          // tradutor de blocos, criado se o motor for EXEC_JIT
+  decod_t *decod;      // instruções pré-decodificadas, por endereço físico
+  int tam_decod;       // tamanho da memória física
+  // argumento da instrução sendo executada, se veio pré-decodificado
+  bool tem_A1;
+  int A1;
 };
 
 exec_t *exec_cria(mmu_t *mmu, es_t *es)
@@ -18,6 +38,17 @@ exec_t *exec_cria(mmu_t *mmu, es_t *es)
     self->estado = cpue_cria();
     self->mmu = mmu;
     self->es = es;
+    self->jit = NULL;
+    self->tam_decod = mem_tam(mmu_mem(mmu));
+    // calloc zera a memória, todas as entradas começam inválidas
+    self->decod = calloc(self->tam_decod, sizeof(decod_t));
+    self->tem_A1 = false;
+    if (self->decod == NULL) {
+      cpue_destroi(self->estado);
+      free(self);
+      return NULL;
+    }
+    exec_muda_motor(self, EXEC_MOTOR);
   }
   return self;
 }
@@ -26,6 +57,8 @@ void exec_destroi(exec_t *self)
 {
   // eu nao criei memória nem es; quem criou que destrua!
   cpue_destroi(self->estado);
+  free(self->decod);
+  jit_destroi(self->jit);
   free(self);
 }
 
@@ -39,6 +72,39 @@ void exec_altera_estado(exec_t *self, cpu_estado_t *estado)
   cpue_copia(estado, self->estado);
 }
 
+// funções de acesso à memória para o código gerado pelo JIT
+static bool jit_le(void *arg, int endereco, int *pvalor);
+static bool jit_escr(void *arg, int endereco, int valor);
+
+void exec_muda_motor(exec_t *self, exec_motor_t motor)
+{
+  if (motor == EXEC_JIT && self->jit == NULL) {
+    self->jit = jit_cria(self->tam_decod, self, jit_le, jit_escr);
+    if (self->jit == NULL) {
+      // JIT não disponível nesta arquitetura, usa o interpretador
+      motor = EXEC_ENCADEADO;
+    }
+  }
+#ifndef __GNUC__
+  if (motor == EXEC_ENCADEADO) motor = EXEC_SWITCH;
+#endif
+  self->motor = motor;
+}
+
+void exec_invalida(exec_t *self, int end_fis, int tam)
+{
+  // a instrução no endereço anterior pode ter o argumento na região
+  int ini = end_fis > 0 ? end_fis - 1 : 0;
+  int fim = end_fis + tam;
+  if (fim > self->tam_decod) fim = self->tam_decod;
+  for (int e = ini; e < fim; e++) {
+    self->decod[e].valida = false;
+  }
+  if (self->jit != NULL) {
+    jit_invalida(self->jit, end_fis, tam);
+  }
+}
+
 
 // ---------------------------------------------------------------------
 // funções auxiliares para usar durante a execução das instruções
@@ -54,15 +120,52 @@ static bool pega_mem(exec_t *self, int endereco, int *pval)
   return err == ERR_OK;
 }
 
+// busca a instrução no endereço 'PC', coloca o opcode em '*popc'
+// usa a forma pré-decodificada, se houver, ou decodifica e guarda
+// se o argumento estiver na mesma página, coloca em '*pA1' e retorna
+//   em '*ptem_A1' true; senão ele deve ser lido da memória
+static bool pega_instrucao(exec_t *self, int PC,
+                           int *popc, int *pA1, bool *ptem_A1)
+{
+  int end_fis;
+  err_t err = mmu_traduz(self->mmu, PC, false, &end_fis);
+  if (err != ERR_OK) {
+    cpue_muda_erro(self->estado, err, PC);
+    return false;
+  }
+  decod_t *d = &self->decod[end_fis];
+  if (!d->valida) {
+    mem_le(mmu_mem(self->mmu), end_fis, &d->opcode);
+    // o argumento só é decodificado se estiver na mesma página, senão a
+    //   página seguinte poderia mudar de quadro sem invalidar esta entrada
+    int tam_pag = mmu_tam_pag(self->mmu);
+    d->tem_A1 = end_fis + 1 < self->tam_decod
+                && (tam_pag == 0 || (PC+1) % tam_pag != 0);
+    if (d->tem_A1) {
+      mem_le(mmu_mem(self->mmu), end_fis + 1, &d->A1);
+    }
+    d->valida = true;
+  }
+  *popc = d->opcode;
+  *pA1 = d->A1;
+  *ptem_A1 = d->tem_A1;
+  return true;
+}
+
 // lê o opcode da instrução no PC
 static bool pega_opcode(exec_t *self, int *popc)
 {
-  return pega_mem(self, cpue_PC(self->estado), popc);
+  return pega_instrucao(self, cpue_PC(self->estado),
+                        popc, &self->A1, &self->tem_A1);
 }
 
 // lê o argumento 1 da instrução no PC
 static bool pega_A1(exec_t *self, int *pA1)
 {
+  if (self->tem_A1) {
+    *pA1 = self->A1;
+    return true;
+  }
   return pega_mem(self, cpue_PC(self->estado) + 1, pA1);
 }
 
@@ -77,13 +180,19 @@ static void incrementa_PC2(exec_t *self)
 }
 
 // escreve um valor na memória
+// invalida a instrução pré-decodificada que estiver nesse endereço ou que
+//   tenha nele o seu argumento (CHAMA, por exemplo, escreve no código)
 static bool poe_mem(exec_t *self, int endereco, int val)
 {
-  err_t err = mmu_escreve(self->mmu, endereco, val);
+  int end_fis;
+  err_t err = mmu_traduz(self->mmu, endereco, true, &end_fis);
   if (err != ERR_OK) {
     cpue_muda_erro(self->estado, err, endereco);
+    return false;
   }
-  return err == ERR_OK;
+  exec_invalida(self, end_fis, 1);
+  mem_escreve(mmu_mem(self->mmu), end_fis, val);
+  return true;
 }
 
 // lê um valor da E/S
@@ -106,6 +215,16 @@ static bool poe_es(exec_t *self, int dispositivo, int val)
   return err == ERR_OK;
 }
 
+static bool jit_le(void *arg, int endereco, int *pvalor)
+{
+  return pega_mem(arg, endereco, pvalor);
+}
+
+static bool jit_escr(void *arg, int endereco, int valor)
+{
+  return poe_mem(arg, endereco, valor);
+}
+
 // ---------------------------------------------------------------------
 // funções auxiliares para implementação de cada instrução
 
@@ -332,45 +451,338 @@ static void op_SISOP(exec_t *self) // chamada ao SO
 }
 
 
-err_t exec_executa_1(exec_t *self)
+// retorna true se a instrução acessa dispositivos de E/S
+// essas instruções só são executadas no início de um lote, para que o
+//   relógio (que o controlador só atualiza no final do lote) esteja certo
+static bool instr_de_es(int opcode)
+{
+  return opcode == LE || opcode == ESCR;
+}
+
+// executa até 'n' instruções despachando pelo opcode com um switch
+// retorna o número de instruções executadas (inclusive a que causou erro)
+static int executa_switch(exec_t *self, int n)
+{
+  int feitas = 0;
+  while (feitas < n) {
+    int opcode;
+    if (!pega_opcode(self, &opcode)) return feitas + 1;
+    if (feitas > 0 && instr_de_es(opcode)) break;
+    feitas++;
+
+    switch (opcode) {
+      case NOP:    op_NOP(self);    break;
+      case PARA:   op_PARA(self);   break;
+      case CARGI:  op_CARGI(self);  break;
+      case CARGM:  op_CARGM(self);  break;
+      case CARGX:  op_CARGX(self);  break;
+      case ARMM:   op_ARMM(self);   break;
+      case ARMX:   op_ARMX(self);   break;
+      case MVAX:   op_MVAX(self);   break;
+      case MVXA:   op_MVXA(self);   break;
+      case INCX:   op_INCX(self);   break;
+      case SOMA:   op_SOMA(self);   break;
+      case SUB:    op_SUB(self);    break;
+      case MULT:   op_MULT(self);   break;
+      case DIV:    op_DIV(self);    break;
+      case RESTO:  op_RESTO(self);  break;
+      case NEG:    op_NEG(self);    break;
+      case DESV:   op_DESV(self);   break;
+      case DESVZ:  op_DESVZ(self);  break;
+      case DESVNZ: op_DESVNZ(self); break;
+      case DESVN:  op_DESVN(self);  break;
+      case DESVP:  op_DESVP(self);  break;
+      case CHAMA:  op_CHAMA(self);  break;
+      case RET:    op_RET(self);    break;
+      case LE:     op_LE(self);     break;
+      case ESCR:   op_ESCR(self);   break;
+      case SISOP:  op_SISOP(self);  break;
+      default:     cpue_muda_erro(self->estado, ERR_INSTR_INV, 0);
+    }
+    if (cpue_erro(self->estado) != ERR_OK) break;
+  }
+  return feitas;
+}
+
+
+#ifdef __GNUC__
+// ---------------------------------------------------------------------
+// motor com despacho encadeado (direct threading, usa a extensão
+//   "labels as values" do gcc)
+// cada instrução termina desviando diretamente para o código da próxima,
+//   sem passar por um switch central; o código de cada instrução é o
+//   mesmo das funções op_* acima, com os registradores em variáveis locais
+// executa no máximo 'n' instruções, para antes se alguma causar erro
+// retorna o número de instruções executadas (inclusive a que causou erro)
+static int executa_encadeado(exec_t *self, int n)
+{
+  static void *rotulos[SISOP+1] = {
+    [NOP]   = &&l_NOP,   [PARA]   = &&l_PARA,   [CARGI] = &&l_CARGI,
+    [CARGM] = &&l_CARGM, [CARGX]  = &&l_CARGX,  [ARMM]  = &&l_ARMM,
+    [ARMX]  = &&l_ARMX,  [MVAX]   = &&l_MVAX,   [MVXA]  = &&l_MVXA,
+    [INCX]  = &&l_INCX,  [SOMA]   = &&l_SOMA,   [SUB]   = &&l_SUB,
+    [MULT]  = &&l_MULT,  [DIV]    = &&l_DIV,    [RESTO] = &&l_RESTO,
+    [NEG]   = &&l_NEG,   [DESV]   = &&l_DESV,   [DESVZ] = &&l_DESVZ,
+    [DESVNZ]= &&l_DESVNZ,[DESVN]  = &&l_DESVN,  [DESVP] = &&l_DESVP,
+    [CHAMA] = &&l_CHAMA, [RET]    = &&l_RET,    [LE]    = &&l_LE,
+    [ESCR]  = &&l_ESCR,  [SISOP]  = &&l_SISOP,
+  };
+  cpu_estado_t *estado = self->estado;
+  cpu_modo_t modo = cpue_modo(estado);
+  int PC = cpue_PC(estado);
+  int A = cpue_A(estado);
+  int X = cpue_X(estado);
+  int feitas = 0;
+  int opcode, A1, mA1;
+  bool tem_A1;
+
+// busca a próxima instrução e desvia para o seu código
+#define PROXIMA()                                                   \
+  do {                                                              \
+    if (feitas >= n) goto fim;                                      \
+    feitas++;                                                       \
+    if (!pega_instrucao(self, PC, &opcode, &A1, &tem_A1)) goto fim; \
+    if (opcode < 0 || opcode > SISOP) goto l_invalida;              \
+    goto *rotulos[opcode];                                          \
+  } while (0)
+// lê o argumento da instrução e o valor da memória apontado por ele
+#define PEGA_A1()     if (!tem_A1 && !pega_mem(self, PC+1, &A1)) goto fim
+#define PEGA_MA1(end) if (!pega_mem(self, (end), &mA1)) goto fim
+
+  PROXIMA();
+
+l_NOP:
+  PC++;
+  PROXIMA();
+l_PARA:
+  if (modo != supervisor) {
+    cpue_muda_erro(estado, ERR_INSTR_PRIV, PARA);
+    goto fim;
+  }
+  cpue_muda_erro(estado, ERR_CPU_PARADA, 0);
+  goto fim;
+l_CARGI:
+  PEGA_A1();
+  A = A1;
+  PC += 2;
+  PROXIMA();
+l_CARGM:
+  PEGA_A1();
+  PEGA_MA1(A1);
+  A = mA1;
+  PC += 2;
+  PROXIMA();
+l_CARGX:
+  PEGA_A1();
+  PEGA_MA1(A1+X);
+  A = mA1;
+  PC += 2;
+  PROXIMA();
+l_ARMM:
+  PEGA_A1();
+  if (!poe_mem(self, A1, A)) goto fim;
+  PC += 2;
+  PROXIMA();
+l_ARMX:
+  PEGA_A1();
+  if (!poe_mem(self, A1+X, A)) goto fim;
+  PC += 2;
+  PROXIMA();
+l_MVAX:
+  X = A;
+  PC++;
+  PROXIMA();
+l_MVXA:
+  A = X;
+  PC++;
+  PROXIMA();
+l_INCX:
+  X++;
+  PC++;
+  PROXIMA();
+l_SOMA:
+  PEGA_A1();
+  PEGA_MA1(A1);
+  A += mA1;
+  PC += 2;
+  PROXIMA();
+l_SUB:
+  PEGA_A1();
+  PEGA_MA1(A1);
+  A -= mA1;
+  PC += 2;
+  PROXIMA();
+l_MULT:
+  PEGA_A1();
+  PEGA_MA1(A1);
+  A *= mA1;
+  PC += 2;
+  PROXIMA();
+l_DIV:
+  PEGA_A1();
+  PEGA_MA1(A1);
+  A /= mA1;
+  PC += 2;
+  PROXIMA();
+l_RESTO:
+  PEGA_A1();
+  PEGA_MA1(A1);
+  A %= mA1;
+  PC += 2;
+  PROXIMA();
+l_NEG:
+  A = -A;
+  PC++;
+  PROXIMA();
+l_DESV:
+  PEGA_A1();
+  PC = A1;
+  PROXIMA();
+l_DESVZ:
+  if (A == 0) goto l_DESV;
+  PC += 2;
+  PROXIMA();
+l_DESVNZ:
+  if (A != 0) goto l_DESV;
+  PC += 2;
+  PROXIMA();
+l_DESVN:
+  if (A < 0) goto l_DESV;
+  PC += 2;
+  PROXIMA();
+l_DESVP:
+  if (A > 0) goto l_DESV;
+  PC += 2;
+  PROXIMA();
+l_CHAMA:
+  PEGA_A1();
+  if (!poe_mem(self, A1, PC+2)) goto fim;
+  PC = A1+1;
+  PROXIMA();
+l_RET:
+  PEGA_A1();
+  PEGA_MA1(A1);
+  PC = mA1;
+  PROXIMA();
+l_LE:
+  if (feitas > 1) {  // E/S só no início do lote, ver instr_de_es
+    feitas--;
+    goto fim;
+  }
+  if (modo != supervisor) {
+    cpue_muda_erro(estado, ERR_INSTR_PRIV, LE);
+    goto fim;
+  }
+  PEGA_A1();
+  if (!pega_es(self, A1, &mA1)) goto fim;
+  A = mA1;
+  PC += 2;
+  PROXIMA();
+l_ESCR:
+  if (feitas > 1) {
+    feitas--;
+    goto fim;
+  }
+  if (modo != supervisor) {
+    cpue_muda_erro(estado, ERR_INSTR_PRIV, ESCR);
+    goto fim;
+  }
+  PEGA_A1();
+  if (!poe_es(self, A1, A)) goto fim;
+  PC += 2;
+  PROXIMA();
+l_SISOP:
+  PEGA_A1();
+  cpue_muda_erro(estado, ERR_SISOP, A1);
+  // não incrementa o PC, o SO deve fazer isso
+  goto fim;
+l_invalida:
+  cpue_muda_erro(estado, ERR_INSTR_INV, 0);
+
+fim:
+#undef PROXIMA
+#undef PEGA_A1
+#undef PEGA_MA1
+  cpue_muda_PC(estado, PC);
+  cpue_muda_A(estado, A);
+  cpue_muda_X(estado, X);
+  return feitas;
+}
+
+
+// ---------------------------------------------------------------------
+// motor com tradução de blocos para código nativo (ver jit.h)
+// executa os blocos traduzidos enquanto couberem no lote; as instruções
+//   que o JIT não traduz são executadas pelo motor encadeado
+static int executa_jit(exec_t *self, int n)
+{
+  cpu_estado_t *estado = self->estado;
+  int feitas = 0;
+  while (feitas < n) {
+    int PC = cpue_PC(estado);
+    int end_fis;
+    err_t err = mmu_traduz(self->mmu, PC, false, &end_fis);
+    if (err != ERR_OK) {
+      cpue_muda_erro(estado, err, PC);
+      return feitas + 1;
+    }
+    jit_bloco_t *bloco = jit_bloco(self->jit, end_fis, PC,
+                                   mmu_mem(self->mmu), mmu_tam_pag(self->mmu));
+    int num_instr = jit_bloco_num_instr(bloco);
+    if (num_instr == 0 || num_instr > n - feitas) {
+      if (num_instr == 0 && feitas > 0
+          && instr_de_es(jit_bloco_opcode(bloco))) {
+        break;
+      }
+      feitas += executa_encadeado(self, 1);
+    } else {
+      jit_regs_t regs;
+      regs.PC = PC;
+      regs.A = cpue_A(estado);
+      regs.X = cpue_X(estado);
+      jit_executa(self->jit, bloco, &regs);
+      cpue_muda_PC(estado, regs.PC);
+      cpue_muda_A(estado, regs.A);
+      cpue_muda_X(estado, regs.X);
+      feitas += regs.feitas;
+    }
+    if (cpue_erro(estado) != ERR_OK) break;
+  }
+  return feitas;
+}
+#endif // __GNUC__
+
+
+err_t exec_executa_n(exec_t *self, int n, int *pfeitas)
 {
-  // não executa se CPU estiver em estado zumbi
-  if (cpue_modo(self->estado) == zumbi) return ERR_OK;
+  // não executa se CPU estiver em estado zumbi, mas o tempo passa
+  if (cpue_modo(self->estado) == zumbi) {
+    *pfeitas = n;
+    return ERR_OK;
+  }
   // não executa se CPU já estiver em erro
-  if (cpue_erro(self->estado) != ERR_OK) return cpue_erro(self->estado);
+  if (cpue_erro(self->estado) != ERR_OK) {
+    *pfeitas = 1;
+    return cpue_erro(self->estado);
+  }
 
-  int opcode;
-  if (!pega_opcode(self, &opcode)) return cpue_erro(self->estado);
-
-  switch (opcode) {
-    case NOP:    op_NOP(self);    break;
-    case PARA:   op_PARA(self);   break;
-    case CARGI:  op_CARGI(self);  break;
-    case CARGM:  op_CARGM(self);  break;
-    case CARGX:  op_CARGX(self);  break;
-    case ARMM:   op_ARMM(self);   break;
-    case ARMX:   op_ARMX(self);   break;
-    case MVAX:   op_MVAX(self);   break;
-    case MVXA:   op_MVXA(self);   break;
-    case INCX:   op_INCX(self);   break;
-    case SOMA:   op_SOMA(self);   break;
-    case SUB:    op_SUB(self);    break;
-    case MULT:   op_MULT(self);   break;
-    case DIV:    op_DIV(self);    break;
-    case RESTO:  op_RESTO(self);  break;
-    case NEG:    op_NEG(self);    break;
-    case DESV:   op_DESV(self);   break;
-    case DESVZ:  op_DESVZ(self);  break;
-    case DESVNZ: op_DESVNZ(self); break;
-    case DESVN:  op_DESVN(self);  break;
-    case DESVP:  op_DESVP(self);  break;
-    case CHAMA:  op_CHAMA(self);  break;
-    case RET:    op_RET(self);    break;
-    case LE:     op_LE(self);     break;
-    case ESCR:   op_ESCR(self);   break;
-    case SISOP:  op_SISOP(self);  break;
-    default:     cpue_muda_erro(self->estado, ERR_INSTR_INV, 0);
+#ifdef __GNUC__
+  if (self->motor == EXEC_JIT) {
+    *pfeitas = executa_jit(self, n);
+    return cpue_erro(self->estado);
+  }
+  if (self->motor == EXEC_ENCADEADO) {
+    *pfeitas = executa_encadeado(self, n);
+    return cpue_erro(self->estado);
   }
+#endif
+  *pfeitas = executa_switch(self, n);
 
   return cpue_erro(self->estado);
 }
+
+err_t exec_executa_1(exec_t *self)
+{
+  int feitas;
+  return exec_executa_n(self, 1, &feitas);
+}
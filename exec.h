@@ -16,6 +16,20 @@
 
 typedef struct exec_t exec_t; // tipo opaco
 
+// motores de execução de instruções
+//   todos produzem exatamente o mesmo resultado, diferem na velocidade
+typedef enum {
+  EXEC_SWITCH,      // decodifica cada instrução com um switch
+  EXEC_ENCADEADO,   // despacho encadeado (computed goto), se suportado
+  EXEC_JIT,         // blocos traduzidos para código nativo (x86-64)
+} exec_motor_t;
+
+// motor usado se nenhum outro for escolhido em tempo de execução
+// pode ser alterado na compilação com -DEXEC_MOTOR=EXEC_SWITCH
+#ifndef EXEC_MOTOR
+#define EXEC_MOTOR EXEC_ENCADEADO
+#endif
+
 
 // cria uma unidade de execução com acesso à memória e ao
 //   controlador de E/S fornecidos
@@ -28,7 +42,25 @@ void exec_copia_estado(exec_t *exec, cpu_estado_t *estado);
 // altera o estado interno da CPU com o apontado por 'estado'
 void exec_altera_estado(exec_t *exec, cpu_estado_t *estado);
 
+// escolhe o motor usado para executar as instruções
+// se o motor não for suportado, usa o mais próximo que for
+void exec_muda_motor(exec_t *exec, exec_motor_t motor);
+
+// informa que a memória física a partir de 'end_fis', com 'tam' posições,
+//   foi alterada sem passar pela CPU (por exemplo, o SO carregou uma página
+//   em um quadro), para que as instruções pré-decodificadas sejam descartadas
+void exec_invalida(exec_t *exec, int end_fis, int tam);
+
 // executa uma instrução
 err_t exec_executa_1(exec_t *exec);
 
+// executa até 'n' instruções seguidas (n>0), parando na primeira que
+//   causar erro; retorna o erro, ou ERR_OK se nenhuma causou
+// coloca em '*pfeitas' o número de unidades de tempo consumidas, como se
+//   exec_executa_1 tivesse sido chamada esse número de vezes: conta a
+//   instrução que causou erro, e em estado zumbi consome as 'n'
+// instruções de E/S (LE, ESCR) só são executadas como primeira do lote,
+//   para que os dispositivos vejam o relógio atualizado
+err_t exec_executa_n(exec_t *exec, int n, int *pfeitas);
+
 #endif // EXEC_H
@@ -0,0 +1,480 @@
+#include "jit.h"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+
+#include "instr.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#define MAX_INSTR 32                // número máximo de instruções num bloco
+#define MAX_PALAVRAS (2*MAX_INSTR)  // número máximo de posições num bloco
+#define MAX_BLOCOS 8192             // número de blocos antes de recomeçar
+#define TAM_CODIGO (1024*1024)      // tamanho da área de código gerado
+#define TAM_MAX_BLOCO 4096          // espaço reservado para gerar um bloco
+
+struct jit_bloco_t {
+  int end_fis;          // endereço físico da primeira instrução
+  int PC;               // endereço virtual da primeira instrução
+  int tam;              // número de posições de memória ocupadas
+  int num_instr;        // número de instruções traduzidas
+  int opcode;           // opcode da primeira instrução
+  uint8_t *codigo;      // código gerado
+  jit_bloco_t *prox;    // próximo bloco que começa no mesmo endereço físico
+};
+
+struct jit_t {
+  int tam_mem;
+  void *arg;                   // argumento das funções de acesso
+  jit_f_le_t f_le;
+  jit_f_escr_t f_escr;
+  jit_bloco_t **por_inicio;    // blocos, pelo endereço físico de início
+  int *cobertura;              // quantos blocos usam cada endereço físico
+  jit_bloco_t blocos[MAX_BLOCOS];
+  int num_blocos;
+  uint8_t *codigo;             // área de código executável
+  uint8_t *pos;                // onde vai ser gerado o próximo código
+  jit_bloco_t *atual;          // bloco em execução
+  bool atual_invalidado;       // o bloco em execução alterou o seu código
+  // posições no código gerado de desvios para o fim do bloco
+  uint8_t *saidas[2*MAX_INSTR];
+  int num_saidas;
+};
+
+
+// ---------------------------------------------------------------------
+// funções chamadas pelo código gerado
+// retornam 0 se o bloco deve terminar (em geral por erro)
+
+// lê a memória em 'end' para regs->tmp
+static int aux_le(jit_regs_t *r, int end)
+{
+  return r->jit->f_le(r->jit->arg, end, &r->tmp);
+}
+
+// escreve A na memória em 'end' (ARMM, ARMX)
+// se a escrita alterou o próprio bloco, termina depois da instrução
+static int aux_arm(jit_regs_t *r, int end)
+{
+  jit_t *jit = r->jit;
+  if (!jit->f_escr(jit->arg, end, r->A)) return 0;
+  if (jit->atual_invalidado) {
+    r->PC += 2;
+    return 0;
+  }
+  return 1;
+}
+
+// escreve o endereço de retorno na memória em 'end' (CHAMA)
+// CHAMA sempre termina o bloco, não precisa testar se ele foi alterado
+static int aux_chama(jit_regs_t *r, int end)
+{
+  return r->jit->f_escr(r->jit->arg, end, r->PC + 2);
+}
+
+
+// ---------------------------------------------------------------------
+// geração de código
+// o ponteiro para os registradores (jit_regs_t) fica em rbx durante todo
+//   o bloco; os registradores da CPU são acessados como [rbx+desl]
+
+#define D_PC     offsetof(jit_regs_t, PC)
+#define D_A      offsetof(jit_regs_t, A)
+#define D_X      offsetof(jit_regs_t, X)
+#define D_TMP    offsetof(jit_regs_t, tmp)
+#define D_FEITAS offsetof(jit_regs_t, feitas)
+
+static void e1(jit_t *self, uint8_t b)
+{
+  *self->pos++ = b;
+}
+
+static void e4(jit_t *self, int32_t v)
+{
+  memcpy(self->pos, &v, sizeof(v));
+  self->pos += sizeof(v);
+}
+
+// mov dword [rbx+desl], imm32
+static void emite_muda_reg(jit_t *self, int desl, int valor)
+{
+  e1(self, 0xC7); e1(self, 0x43); e1(self, desl); e4(self, valor);
+}
+
+// mov eax, [rbx+desl]
+static void emite_eax_reg(jit_t *self, int desl)
+{
+  e1(self, 0x8B); e1(self, 0x43); e1(self, desl);
+}
+
+// mov [rbx+desl], eax
+static void emite_reg_eax(jit_t *self, int desl)
+{
+  e1(self, 0x89); e1(self, 0x43); e1(self, desl);
+}
+
+// desvio condicional (jcc rel32) para o fim do bloco
+// o deslocamento é preenchido quando o fim do bloco for gerado
+static void emite_saida(jit_t *self, uint8_t cc)
+{
+  e1(self, 0x0F); e1(self, cc);
+  self->saidas[self->num_saidas++] = self->pos;
+  e4(self, 0);
+}
+
+// chama a função auxiliar 'f' com o endereço 'end' (somado a X se
+//   'indexado'); termina o bloco se ela retornar 0
+// antes, registra PC e o número de instruções para o caso de erro
+static void emite_chamada(jit_t *self, void *f, int i, int PC,
+                          int end, bool indexado)
+{
+  emite_muda_reg(self, D_PC, PC);
+  emite_muda_reg(self, D_FEITAS, i+1);
+  e1(self, 0x48); e1(self, 0x89); e1(self, 0xDF);   // mov rdi, rbx
+  e1(self, 0xBE); e4(self, end);                    // mov esi, end
+  if (indexado) {
+    e1(self, 0x03); e1(self, 0x73); e1(self, D_X);  // add esi, [rbx+X]
+  }
+  e1(self, 0x48); e1(self, 0xB8);                   // mov rax, f
+  uint64_t ender = (uint64_t)(uintptr_t)f;
+  memcpy(self->pos, &ender, sizeof(ender));
+  self->pos += sizeof(ender);
+  e1(self, 0xFF); e1(self, 0xD0);                   // call rax
+  e1(self, 0x85); e1(self, 0xC0);                   // test eax, eax
+  emite_saida(self, 0x84);                          // jz fim
+}
+
+// desvio condicional: 'cc_nao' é o jcc curto que pula o desvio (não desvia)
+static void emite_desvio_cond(jit_t *self, uint8_t cc_nao, int PC, int A1)
+{
+  emite_muda_reg(self, D_PC, PC+2);
+  e1(self, 0x83); e1(self, 0x7B); e1(self, D_A); e1(self, 0);  // cmp [A], 0
+  e1(self, cc_nao); e1(self, 7);           // pula o mov abaixo (7 bytes)
+  emite_muda_reg(self, D_PC, A1);
+}
+
+// retorna true se o JIT sabe traduzir a instrução
+static bool traduzivel(int opcode)
+{
+  switch (opcode) {
+    case NOP: case CARGI: case CARGM: case CARGX: case ARMM: case ARMX:
+    case MVAX: case MVXA: case INCX: case SOMA: case SUB: case MULT:
+    case DIV: case RESTO: case NEG: case DESV: case DESVZ: case DESVNZ:
+    case DESVN: case DESVP: case CHAMA: case RET:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// retorna true se a instrução termina o bloco
+static bool termina_bloco(int opcode)
+{
+  return opcode >= DESV && opcode <= RET;
+}
+
+// gera o código da instrução 'i' do bloco, no endereço virtual 'PC'
+// as instruções que não desviam não alteram o PC, o fim do bloco faz isso
+static void emite_instrucao(jit_t *self, int i, int PC, int opcode, int A1)
+{
+  switch (opcode) {
+    case NOP:
+      break;
+    case CARGI:
+      emite_muda_reg(self, D_A, A1);
+      break;
+    case CARGM:
+    case CARGX:
+      emite_chamada(self, aux_le, i, PC, A1, opcode == CARGX);
+      emite_eax_reg(self, D_TMP);
+      emite_reg_eax(self, D_A);
+      break;
+    case ARMM:
+    case ARMX:
+      emite_chamada(self, aux_arm, i, PC, A1, opcode == ARMX);
+      break;
+    case MVAX:
+      emite_eax_reg(self, D_A);
+      emite_reg_eax(self, D_X);
+      break;
+    case MVXA:
+      emite_eax_reg(self, D_X);
+      emite_reg_eax(self, D_A);
+      break;
+    case INCX:
+      e1(self, 0x83); e1(self, 0x43); e1(self, D_X); e1(self, 1); // add [X],1
+      break;
+    case SOMA:
+    case SUB:
+      emite_chamada(self, aux_le, i, PC, A1, false);
+      emite_eax_reg(self, D_TMP);
+      e1(self, opcode == SOMA ? 0x01 : 0x29);  // add/sub [rbx+A], eax
+      e1(self, 0x43); e1(self, D_A);
+      break;
+    case MULT:
+      emite_chamada(self, aux_le, i, PC, A1, false);
+      emite_eax_reg(self, D_A);
+      e1(self, 0x0F); e1(self, 0xAF); e1(self, 0x43); e1(self, D_TMP); // imul
+      emite_reg_eax(self, D_A);
+      break;
+    case DIV:
+    case RESTO:
+      emite_chamada(self, aux_le, i, PC, A1, false);
+      emite_eax_reg(self, D_A);
+      e1(self, 0x99);                                          // cdq
+      e1(self, 0xF7); e1(self, 0x7B); e1(self, D_TMP);         // idiv [tmp]
+      if (opcode == DIV) {
+        emite_reg_eax(self, D_A);
+      } else {
+        e1(self, 0x89); e1(self, 0x53); e1(self, D_A);         // mov [A], edx
+      }
+      break;
+    case NEG:
+      e1(self, 0xF7); e1(self, 0x5B); e1(self, D_A);           // neg [A]
+      break;
+    case DESV:
+      emite_muda_reg(self, D_PC, A1);
+      break;
+    case DESVZ:
+      emite_desvio_cond(self, 0x75, PC, A1);  // jne
+      break;
+    case DESVNZ:
+      emite_desvio_cond(self, 0x74, PC, A1);  // je
+      break;
+    case DESVN:
+      emite_desvio_cond(self, 0x7D, PC, A1);  // jge
+      break;
+    case DESVP:
+      emite_desvio_cond(self, 0x7E, PC, A1);  // jle
+      break;
+    case CHAMA:
+      emite_chamada(self, aux_chama, i, PC, A1, false);
+      emite_muda_reg(self, D_PC, A1+1);
+      break;
+    case RET:
+      emite_chamada(self, aux_le, i, PC, A1, false);
+      emite_eax_reg(self, D_TMP);
+      emite_reg_eax(self, D_PC);
+      break;
+  }
+}
+
+
+// ---------------------------------------------------------------------
+// gerência dos blocos
+
+// descarta todos os blocos e todo o código gerado
+static void esvazia(jit_t *self)
+{
+  memset(self->por_inicio, 0, self->tam_mem * sizeof(*self->por_inicio));
+  memset(self->cobertura, 0, self->tam_mem * sizeof(*self->cobertura));
+  self->num_blocos = 0;
+  self->pos = self->codigo;
+}
+
+// altera a contagem de blocos que usam as posições ocupadas por 'b'
+static void cobre(jit_t *self, jit_bloco_t *b, int delta)
+{
+  for (int e = b->end_fis; e < b->end_fis + b->tam; e++) {
+    self->cobertura[e] += delta;
+  }
+}
+
+// traduz o bloco que começa em 'PC' (físico 'end_fis')
+static jit_bloco_t *traduz(jit_t *self, int end_fis, int PC,
+                           mem_t *mem, int tam_pag)
+{
+  if (self->num_blocos >= MAX_BLOCOS
+      || self->pos + TAM_MAX_BLOCO > self->codigo + TAM_CODIGO) {
+    esvazia(self);
+  }
+  jit_bloco_t *b = &self->blocos[self->num_blocos++];
+  b->end_fis = end_fis;
+  b->PC = PC;
+  b->codigo = self->pos;
+  b->num_instr = 0;
+  b->opcode = -1;
+  self->num_saidas = 0;
+
+  e1(self, 0x53);                               // push rbx
+  e1(self, 0x48); e1(self, 0x89); e1(self, 0xFB); // mov rbx, rdi
+
+  int pc = PC;
+  int fis = end_fis;
+  bool desviou = false;
+  while (b->num_instr < MAX_INSTR && !desviou) {
+    int opcode, A1 = 0;
+    if (mem_le(mem, fis, &opcode) != ERR_OK) break;
+    if (b->num_instr == 0) b->opcode = opcode;
+    if (!traduzivel(opcode) || PC < 0) break;
+    int tam = instr_num_args(opcode) + 1;
+    // a instrução inteira tem que estar na página do início do bloco
+    if (tam_pag != 0 && (pc + tam - 1) / tam_pag != PC / tam_pag) break;
+    if (fis + tam > self->tam_mem) break;
+    if (tam > 1) mem_le(mem, fis + 1, &A1);
+    emite_instrucao(self, b->num_instr, pc, opcode, A1);
+    b->num_instr++;
+    pc += tam;
+    fis += tam;
+    desviou = termina_bloco(opcode);
+  }
+
+  if (b->num_instr == 0) {
+    // nada traduzido; o bloco só guarda o opcode para o interpretador
+    self->pos = b->codigo;
+    b->codigo = NULL;
+    b->tam = 1;
+  } else {
+    b->tam = fis - end_fis;
+    if (!desviou) {
+      emite_muda_reg(self, D_PC, pc);
+    }
+    emite_muda_reg(self, D_FEITAS, b->num_instr);
+    // fim do bloco, as saídas antecipadas (por erro) desviam para cá
+    for (int i = 0; i < self->num_saidas; i++) {
+      int32_t rel = self->pos - (self->saidas[i] + 4);
+      memcpy(self->saidas[i], &rel, sizeof(rel));
+    }
+    e1(self, 0x5B);                             // pop rbx
+    e1(self, 0xC3);                             // ret
+  }
+
+  b->prox = self->por_inicio[end_fis];
+  self->por_inicio[end_fis] = b;
+  cobre(self, b, 1);
+  return b;
+}
+
+
+// ---------------------------------------------------------------------
+// funções públicas
+
+jit_t *jit_cria(int tam_mem, void *arg, jit_f_le_t f_le, jit_f_escr_t f_escr)
+{
+  jit_t *self = malloc(sizeof(*self));
+  if (self == NULL) return NULL;
+  self->tam_mem = tam_mem;
+  self->arg = arg;
+  self->f_le = f_le;
+  self->f_escr = f_escr;
+  self->por_inicio = calloc(tam_mem, sizeof(*self->por_inicio));
+  self->cobertura = calloc(tam_mem, sizeof(*self->cobertura));
+  self->codigo = mmap(NULL, TAM_CODIGO, PROT_READ | PROT_WRITE | PROT_EXEC,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (self->por_inicio == NULL || self->cobertura == NULL
+      || self->codigo == MAP_FAILED) {
+    if (self->codigo != MAP_FAILED) munmap(self->codigo, TAM_CODIGO);
+    free(self->por_inicio);
+    free(self->cobertura);
+    free(self);
+    return NULL;
+  }
+  self->atual = NULL;
+  self->atual_invalidado = false;
+  esvazia(self);
+  return self;
+}
+
+void jit_destroi(jit_t *self)
+{
+  if (self != NULL) {
+    munmap(self->codigo, TAM_CODIGO);
+    free(self->por_inicio);
+    free(self->cobertura);
+    free(self);
+  }
+}
+
+jit_bloco_t *jit_bloco(jit_t *self, int end_fis, int PC,
+                       mem_t *mem, int tam_pag)
+{
+  for (jit_bloco_t *b = self->por_inicio[end_fis]; b != NULL; b = b->prox) {
+    if (b->PC == PC) return b;
+  }
+  return traduz(self, end_fis, PC, mem, tam_pag);
+}
+
+int jit_bloco_num_instr(jit_bloco_t *bloco)
+{
+  return bloco->num_instr;
+}
+
+int jit_bloco_opcode(jit_bloco_t *bloco)
+{
+  return bloco->opcode;
+}
+
+void jit_executa(jit_t *self, jit_bloco_t *bloco, jit_regs_t *regs)
+{
+  void (*f)(jit_regs_t *) = (void (*)(jit_regs_t *))bloco->codigo;
+  regs->jit = self;
+  self->atual = bloco;
+  self->atual_invalidado = false;
+  f(regs);
+  self->atual = NULL;
+}
+
+void jit_invalida(jit_t *self, int end_fis, int tam)
+{
+  int ini = end_fis < 0 ? 0 : end_fis;
+  int fim = end_fis + tam > self->tam_mem ? self->tam_mem : end_fis + tam;
+  for (int e = ini; e < fim; e++) {
+    if (self->cobertura[e] == 0) continue;
+    // procura os blocos que usam 'e' entre os que começam antes dele
+    int inicio = e - MAX_PALAVRAS + 1 < 0 ? 0 : e - MAX_PALAVRAS + 1;
+    for (int i = inicio; i <= e; i++) {
+      jit_bloco_t **pb = &self->por_inicio[i];
+      while (*pb != NULL) {
+        jit_bloco_t *b = *pb;
+        if (b->end_fis + b->tam > e) {
+          // remove o bloco; o código só é reaproveitado quando a área
+          //   de código for esvaziada, nunca durante a execução
+          *pb = b->prox;
+          cobre(self, b, -1);
+          if (b == self->atual) self->atual_invalidado = true;
+        } else {
+          pb = &b->prox;
+        }
+      }
+    }
+  }
+}
+
+#else // arquitetura não suportada
+
+jit_t *jit_cria(int tam_mem, void *arg, jit_f_le_t f_le, jit_f_escr_t f_escr)
+{
+  return NULL;
+}
+
+void jit_destroi(jit_t *self)
+{
+}
+
+jit_bloco_t *jit_bloco(jit_t *self, int end_fis, int PC,
+                       mem_t *mem, int tam_pag)
+{
+  return NULL;
+}
+
+int jit_bloco_num_instr(jit_bloco_t *bloco)
+{
+  return 0;
+}
+
+int jit_bloco_opcode(jit_bloco_t *bloco)
+{
+  return -1;
+}
+
+void jit_executa(jit_t *self, jit_bloco_t *bloco, jit_regs_t *regs)
+{
+}
+
+void jit_invalida(jit_t *self, int end_fis, int tam)
+{
+}
+
+#endif
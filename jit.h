@@ -0,0 +1,69 @@
+#ifndef JIT_H
+#define JIT_H
+
+// tradutor dinâmico (JIT) de blocos básicos de instruções para código
+//   nativo x86-64
+// um bloco é uma sequência de instruções na mesma página, que termina em
+//   um desvio (DESV*, CHAMA, RET) ou antes de uma instrução que o JIT não
+//   traduz (PARA, LE, ESCR, SISOP, inválida)
+// os blocos são identificados pelo endereço físico e pelo endereço virtual
+//   da primeira instrução, e são descartados quando a memória física que
+//   ocupam é alterada
+// os acessos à memória feitos pelo código gerado passam pelas funções
+//   fornecidas na criação (que passam pela MMU e tratam os erros)
+// em arquiteturas não suportadas, jit_cria retorna NULL
+
+#include <stdbool.h>
+#include "mem.h"
+
+typedef struct jit_t jit_t;              // tipo opaco
+typedef struct jit_bloco_t jit_bloco_t;  // tipo opaco
+
+// registradores da CPU, como são lidos e alterados pelo código gerado
+typedef struct {
+  int PC;
+  int A;
+  int X;
+  int tmp;      // valor lido da memória pelas funções auxiliares
+  int feitas;   // número de instruções executadas pelo bloco
+  jit_t *jit;
+} jit_regs_t;
+
+// funções de acesso à memória virtual usadas pelo código gerado
+// em caso de erro, alteram o estado da CPU e retornam false
+typedef bool (*jit_f_le_t)(void *arg, int endereco, int *pvalor);
+typedef bool (*jit_f_escr_t)(void *arg, int endereco, int valor);
+
+// cria um JIT para uma memória física de 'tam_mem' posições
+// 'f_le' e 'f_escr' são chamadas com 'arg' para os acessos à memória
+// retorna NULL se não for possível (ou a arquitetura não for suportada)
+jit_t *jit_cria(int tam_mem, void *arg, jit_f_le_t f_le, jit_f_escr_t f_escr);
+
+// destrói o JIT e todo o código gerado
+void jit_destroi(jit_t *self);
+
+// retorna o bloco que começa no endereço virtual 'PC', que corresponde ao
+//   endereço físico 'end_fis', traduzindo-o se ainda não existir
+// as instruções são lidas de 'mem'; 'tam_pag' é o tamanho das páginas
+//   (0 se não houver paginação), um bloco não passa do fim da página
+jit_bloco_t *jit_bloco(jit_t *self, int end_fis, int PC,
+                       mem_t *mem, int tam_pag);
+
+// retorna o número de instruções do bloco; 0 se a primeira instrução não
+//   pode ser traduzida (deve ser executada pelo interpretador)
+int jit_bloco_num_instr(jit_bloco_t *bloco);
+
+// retorna o opcode da primeira instrução do bloco
+int jit_bloco_opcode(jit_bloco_t *bloco);
+
+// executa o bloco com os registradores em 'regs'
+// ao final, 'regs' contém os novos valores dos registradores e em
+//   'regs->feitas' o número de instruções executadas (inclusive a que
+//   causou erro, se houver)
+void jit_executa(jit_t *self, jit_bloco_t *bloco, jit_regs_t *regs);
+
+// informa que a memória física a partir de 'end_fis', com 'tam' posições,
+//   foi alterada; os blocos que usam essa região são descartados
+void jit_invalida(jit_t *self, int end_fis, int tam);
+
+#endif // JIT_H
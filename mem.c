@@ -1,5 +1,6 @@
 #include "mem.h"
 #include <stdlib.h>
+#include <string.h>
 
 // tipo de dados opaco para representar uma região de memória
 struct mem_t {
@@ -38,11 +39,9 @@ int mem_tam(mem_t *self)
 }
 
 void mem_copia(mem_t* self, mem_t* outro) {
-  int valor;
-  for(int c=0; c < mem_tam(self); c++) {
-    mem_le(self, c, &valor);
-    mem_escreve(outro, c, valor);
-  }
+  int tam = mem_tam(self);
+  if (tam > mem_tam(outro)) tam = mem_tam(outro);
+  mem_escreve_bloco(outro, 0, self->conteudo, tam);
 }
 
 // função auxiliar, verifica se endereço é válido
@@ -54,6 +53,41 @@ static err_t verif_permissao(mem_t *self, int endereco)
   return ERR_OK;
 }
 
+// função auxiliar, verifica se o bloco de endereços é válido
+static err_t verif_bloco(mem_t *self, int endereco, int tam)
+{
+  if (endereco < 0 || tam < 0 || endereco > self->tam - tam) {
+    return ERR_END_INV;
+  }
+  return ERR_OK;
+}
+
+err_t mem_le_bloco(mem_t *self, int endereco, int *dest, int tam)
+{
+  err_t err = verif_bloco(self, endereco, tam);
+  if (err == ERR_OK) {
+    memcpy(dest, &self->conteudo[endereco], tam * sizeof(*dest));
+  }
+  return err;
+}
+
+err_t mem_escreve_bloco(mem_t *self, int endereco, int *orig, int tam)
+{
+  err_t err = verif_bloco(self, endereco, tam);
+  if (err == ERR_OK) {
+    memcpy(&self->conteudo[endereco], orig, tam * sizeof(*orig));
+  }
+  return err;
+}
+
+int *mem_ponteiro(mem_t *self, int endereco)
+{
+  if (verif_permissao(self, endereco) != ERR_OK) {
+    return NULL;
+  }
+  return &self->conteudo[endereco];
+}
+
 err_t mem_le(mem_t *self, int endereco, int *pvalor)
 {
   err_t err = verif_permissao(self, endereco);
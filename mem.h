@@ -25,6 +25,22 @@ int mem_tam(mem_t *self);
 // copia os dados de um descritor para outro
 void mem_copia(mem_t* self, mem_t* outro);
 
+// copia 'tam' valores a partir do endereço 'endereco' para 'dest'
+// retorna erro ERR_END_INV (e não altera 'dest') se algum endereço for
+//   inválido
+err_t mem_le_bloco(mem_t *self, int endereco, int *dest, int tam);
+
+// copia 'tam' valores de 'orig' para a memória, a partir do endereço
+//   'endereco'
+// retorna erro ERR_END_INV (e não altera a memória) se algum endereço for
+//   inválido
+err_t mem_escreve_bloco(mem_t *self, int endereco, int *orig, int tam);
+
+// retorna um ponteiro para a posição 'endereco' da memória, para acesso
+//   direto (sem verificação de endereço a cada acesso)
+// retorna NULL se o endereço for inválido
+int *mem_ponteiro(mem_t *self, int endereco);
+
 // coloca na posição apontada por 'pvalor' o valor no endereço 'endereco'
 // retorna erro ERR_END_INV (e não altera '*pvalor') se endereço inválido
 err_t mem_le(mem_t *self, int endereco, int *pvalor);
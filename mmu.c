@@ -1,14 +1,94 @@
 #include "mmu.h"
 #include "tab_pag.h"
+#include "traco.h"
 #include <stdlib.h>
 
+// TLB: guarda as traduções mais recentes, indexada pelo número da página
+//   e pelo identificador do espaço de endereçamento (ASID) da tabela
+//   (mapeamento direto)
+// as traduções de uma tabela continuam na TLB quando outra tabela passa
+//   a ser usada, e podem ser aproveitadas quando ela voltar a ser usada
+// cada entrada tem o ponteiro para o início do quadro na memória física,
+//   um acerto não precisa consultar a tabela de páginas nem verificar o
+//   endereço físico
+// o bit de acesso da página é ligado quando a entrada é preenchida, o de
+//   alteração na primeira escrita pela entrada; a tabela avisa quando uma
+//   página muda (ou tem esses bits desligados), e a entrada é invalidada
+// uma escrita em uma página protegida não é feita pela TLB, a tabela de
+//   páginas é consultada e o acesso causa falha de página
+#define TLB_TAM 64  // número de entradas, potência de 2
+
+// cache do percurso: numa falha da TLB, a tradução passa pelo diretório da
+//   tabela de páginas para chegar à folha da página; as folhas encontradas
+//   são guardadas (mapeamento direto, pelo número da folha e pelo ASID), e
+//   as outras páginas de uma folha guardada são traduzidas direto pela folha
+// uma folha existe até a sua tabela ser destruída, quando as entradas da
+//   tabela são invalidadas; uma folha que ainda não existe não é guardada
+#define PERCURSO_TAM 16  // número de entradas, potência de 2
+
+typedef struct {
+  bool valida;     // a entrada contém uma tradução
+  int asid;        // o espaço de endereçamento da tradução
+  int pagina;      // a página traduzida
+  int end_quadro;  // endereço físico do início do quadro
+  int *quadro;     // ponteiro para o início do quadro na memória
+  bool alterada;   // o bit de alteração da página já foi ligado
+  bool protegida;  // a página não pode ser escrita
+  int troca;       // troca de tabela em que a entrada foi usada por último
+} tlb_ent_t;
+
+typedef struct {
+  int asid;               // o espaço de endereçamento (-1 se a entrada está vazia)
+  int folha;              // o número da folha
+  tab_pag_folha_t *ptr;   // a folha
+} percurso_ent_t;
+
 // tipo de dados opaco para representar o controlador de memória
 struct mmu_t {
   mem_t *mem;          // a memória física
   tab_pag_t *tab_pag;  // a tabela de páginas
+  int tam_pag;         // o tamanho das páginas (0 se não houver tabela)
+  int bits_pag;        // log2 de tam_pag, se for potência de 2 (senão -1)
+  int bits_folha;      // log2 do número de páginas de uma folha da tabela
+  int asid;            // o espaço de endereçamento da tabela em uso
+  int trocas;          // número de trocas de tabela
   int ultimo_endereco; // o último endereço virtual traduzido pela MMU
+  tlb_ent_t tlb[TLB_TAM];
+  percurso_ent_t percurso[PERCURSO_TAM];
+  int tlb_acertos;     // traduções feitas pela TLB
+  int tlb_falhas;      // traduções que precisaram da tabela de páginas
+  int tlb_salvas;      // entradas de antes da troca de tabela reusadas
+  FILE *traco;         // onde gravar as referências (NULL se não grava)
+  bool traco_cab;      // o cabeçalho do traço já foi gravado
+  traco_reg_t ultimo_reg; // a última referência gravada
 };
 
+// registro que não corresponde a nenhuma referência gravada
+#define TRACO_NENHUM 0xffffffff
+
+// a entrada da TLB para a página 'pagina' do espaço 'asid'
+static inline int tlb_indice(int asid, int pagina)
+{
+  return (pagina + asid * 11) & (TLB_TAM - 1);
+}
+
+// a entrada da cache do percurso para a folha 'folha' do espaço 'asid'
+static inline int percurso_indice(int asid, int folha)
+{
+  return (folha + asid * 3) & (PERCURSO_TAM - 1);
+}
+
+static void tlb_esvazia(mmu_t *self)
+{
+  for (int i = 0; i < TLB_TAM; i++) {
+    self->tlb[i].valida = false;
+    self->tlb[i].asid = -1;
+  }
+  for (int i = 0; i < PERCURSO_TAM; i++) {
+    self->percurso[i].asid = -1;
+  }
+}
+
 mmu_t *mmu_cria(mem_t *mem)
 {
   mmu_t *self;
@@ -16,6 +96,16 @@ mmu_t *mmu_cria(mem_t *mem)
   if (self != NULL) {
     self->mem = mem;
     self->tab_pag = NULL;
+    self->tam_pag = 0;
+    self->bits_pag = -1;
+    self->bits_folha = 0;
+    self->asid = -1;
+    self->trocas = 0;
+    self->tlb_acertos = 0;
+    self->tlb_falhas = 0;
+    self->tlb_salvas = 0;
+    self->traco = NULL;
+    tlb_esvazia(self);
   }
   return self;
 }
@@ -27,49 +117,286 @@ void mmu_destroi(mmu_t *self)
   }
 }
 
+// chamada pela tabela de páginas quando uma página muda
+static void tab_pag_mudou(void *arg, tab_pag_t *tab_pag, int pag)
+{
+  mmu_t *self = arg;
+  int asid = tab_pag_asid(tab_pag);
+  if (pag == -1) {
+    // a tabela vai ser destruída, suas traduções não valem mais
+    for (int i = 0; i < TLB_TAM; i++) {
+      if (self->tlb[i].asid == asid) {
+        self->tlb[i].valida = false;
+      }
+    }
+    // e suas folhas vão ser liberadas
+    for (int i = 0; i < PERCURSO_TAM; i++) {
+      if (self->percurso[i].asid == asid) {
+        self->percurso[i].asid = -1;
+      }
+    }
+    if (tab_pag == self->tab_pag) {
+      self->tab_pag = NULL;
+      self->tam_pag = 0;
+      self->bits_pag = -1;
+      self->asid = -1;
+    }
+    return;
+  }
+  tlb_ent_t *ent = &self->tlb[tlb_indice(asid, pag)];
+  if (ent->asid == asid && ent->pagina == pag) {
+    ent->valida = false;
+  }
+}
+
 void mmu_usa_tab_pag(mmu_t *self, tab_pag_t *tab_pag)
 {
+  if (tab_pag == self->tab_pag) {
+    return;
+  }
   self->tab_pag = tab_pag;
+  self->tam_pag = 0;
+  self->bits_pag = -1;
+  self->asid = -1;
+  self->trocas++;
+  if (tab_pag != NULL) {
+    self->tam_pag = tab_pag_tam_pag(tab_pag);
+    self->bits_pag = tab_pag_bits_pag(tab_pag);
+    self->bits_folha = tab_pag_bits_folha(tab_pag);
+    self->asid = tab_pag_asid(tab_pag);
+    tab_pag_observa(tab_pag, tab_pag_mudou, self);
+  }
+}
+
+// função auxiliar, grava no traço a referência à página 'pagina' da tabela
+//   em uso
+static inline void grava_traco(mmu_t *self, int pagina, bool escrita)
+{
+  if (self->traco == NULL) {
+    return;
+  }
+  traco_reg_t reg = traco_reg(self->asid, pagina, escrita);
+  // outro acesso à página da última referência (ou uma leitura depois de
+  //   uma escrita) não muda o resultado de nenhum algoritmo
+  if (reg == self->ultimo_reg || (reg | 1) == self->ultimo_reg) {
+    return;
+  }
+  if (!self->traco_cab) {
+    traco_cab_t cab = { TRACO_MAGICO, self->tam_pag };
+    fwrite(&cab, sizeof(cab), 1, self->traco);
+    self->traco_cab = true;
+  }
+  fwrite(&reg, sizeof(reg), 1, self->traco);
+  self->ultimo_reg = reg;
 }
 
-// função auxiliar, traduz um endereço virtual em físico
-static err_t traduz_endereco(mmu_t *self, int end_v, int *end_f,
-                             int *ppag, int *pdesl, int *pquadro)
+// função auxiliar, procura a tradução de 'endereco' na TLB
+// retorna a entrada e coloca o deslocamento na página em '*pdesl', ou
+//   retorna NULL se a tradução não estiver na TLB
+static inline tlb_ent_t *tlb_busca(mmu_t *self, int endereco, bool escrita,
+                                   int *pdesl)
 {
-  self->ultimo_endereco = end_v;
+  if (endereco < 0) {
+    return NULL;
+  }
+  // a divisão pelo tamanho da página é a operação mais cara de um acerto
+  int pagina = self->bits_pag >= 0 ? endereco >> self->bits_pag
+                                   : endereco / self->tam_pag;
+  tlb_ent_t *ent = &self->tlb[tlb_indice(self->asid, pagina)];
+  if (!ent->valida || ent->pagina != pagina || ent->asid != self->asid) {
+    return NULL;
+  }
+  if (escrita && ent->protegida) {
+    return NULL;
+  }
+  if (ent->troca != self->trocas) {
+    // tradução que teria sido perdida se a TLB fosse esvaziada na troca
+    self->tlb_salvas++;
+    ent->troca = self->trocas;
+  }
+  if (escrita && !ent->alterada) {
+    tab_pag_muda_alterada(self->tab_pag, pagina, true);
+    ent->alterada = true;
+  }
+  self->tlb_acertos++;
+  grava_traco(self, pagina, escrita);
+  *pdesl = endereco - pagina * self->tam_pag;
+  return ent;
+}
+
+// função auxiliar, coloca na TLB a tradução da página 'pagina' para o
+//   endereço físico 'end_quadro', se o quadro inteiro estiver na memória
+static void tlb_preenche(mmu_t *self, int pagina, int end_quadro,
+                         bool escrita, bool protegida)
+{
+  int *quadro = mem_ponteiro(self->mem, end_quadro);
+  if (quadro == NULL
+      || mem_ponteiro(self->mem, end_quadro + self->tam_pag - 1) == NULL) {
+    return;
+  }
+  tlb_ent_t *ent = &self->tlb[tlb_indice(self->asid, pagina)];
+  ent->valida = true;
+  ent->asid = self->asid;
+  ent->pagina = pagina;
+  ent->end_quadro = end_quadro;
+  ent->quadro = quadro;
+  ent->alterada = escrita;
+  ent->protegida = protegida;
+  ent->troca = self->trocas;
+}
+
+// função auxiliar, retorna a folha da tabela com a página 'pagina', pela
+//   cache do percurso se estiver nela (NULL se a folha não existe)
+static inline tab_pag_folha_t *percurso_busca(mmu_t *self, int pagina)
+{
+  if (pagina < 0) {
+    return NULL;
+  }
+  int folha = pagina >> self->bits_folha;
+  percurso_ent_t *ent = &self->percurso[percurso_indice(self->asid, folha)];
+  if (ent->asid != self->asid || ent->folha != folha) {
+    tab_pag_folha_t *ptr = tab_pag_folha(self->tab_pag, pagina);
+    if (ptr == NULL) {
+      return NULL;
+    }
+    ent->asid = self->asid;
+    ent->folha = folha;
+    ent->ptr = ptr;
+  }
+  return ent->ptr;
+}
+
+// função auxiliar, traduz pela tabela de páginas (quando não está na TLB)
+static err_t traduz_pela_tabela(mmu_t *self, int endereco, bool escrita,
+                                int *pend_fis)
+{
+  self->ultimo_endereco = endereco;
   // se não tem tabela de páginas, não traduz
-  if (self->tab_pag == NULL) {
-    *end_f = end_v;
-    return ERR_OK;
+  int end_fis = endereco;
+  int pagina = 0;
+  if (self->tab_pag != NULL) {
+    pagina = self->bits_pag >= 0 && endereco >= 0 ? endereco >> self->bits_pag
+                                                  : endereco / self->tam_pag;
+    int desl = endereco - pagina * self->tam_pag;
+    tab_pag_folha_t *folha = percurso_busca(self, pagina);
+    if (folha == NULL) {
+      // a página está fora da tabela ou é inválida, a tabela diz qual
+      return tab_pag_traduz(self->tab_pag, endereco, NULL, NULL, NULL, NULL);
+    }
+    int quadro;
+    bool protegida;
+    err_t err = tab_pag_acessa(self->tab_pag, folha, pagina, escrita,
+                               &quadro, &protegida);
+    if (err != ERR_OK) {
+      return err;
+    }
+    self->tlb_falhas++;
+    end_fis = quadro * self->tam_pag + desl;
+    tlb_preenche(self, pagina, end_fis - desl, escrita, protegida);
+  }
+  if (end_fis < 0 || end_fis >= mem_tam(self->mem)) {
+    return ERR_END_INV;
+  }
+  if (self->tab_pag != NULL) {
+    grava_traco(self, pagina, escrita);
   }
-  return tab_pag_traduz(self->tab_pag, end_v, end_f, ppag, pdesl, pquadro);
+  *pend_fis = end_fis;
+  return ERR_OK;
+}
+
+err_t mmu_traduz(mmu_t *self, int endereco, bool escrita, int *pend_fis)
+{
+  if (self->tab_pag != NULL) {
+    int desl;
+    tlb_ent_t *ent = tlb_busca(self, endereco, escrita, &desl);
+    if (ent != NULL) {
+      self->ultimo_endereco = endereco;
+      *pend_fis = ent->end_quadro + desl;
+      return ERR_OK;
+    }
+  }
+  return traduz_pela_tabela(self, endereco, escrita, pend_fis);
 }
 
 err_t mmu_le(mmu_t *self, int endereco, int *pvalor)
 {
+  if (self->tab_pag != NULL) {
+    int desl;
+    tlb_ent_t *ent = tlb_busca(self, endereco, false, &desl);
+    if (ent != NULL) {
+      self->ultimo_endereco = endereco;
+      *pvalor = ent->quadro[desl];
+      return ERR_OK;
+    }
+  }
   int end_fis;
-  int pagina;
-  err_t err = traduz_endereco(self, endereco, &end_fis, &pagina, NULL, NULL);
+  err_t err = traduz_pela_tabela(self, endereco, false, &end_fis);
   if (err != ERR_OK) {
     return err;
   }
-  tab_pag_muda_acessada(self->tab_pag, pagina, true);
   return mem_le(self->mem, end_fis, pvalor);
 }
 
 err_t mmu_escreve(mmu_t *self, int endereco, int valor)
 {
+  if (self->tab_pag != NULL) {
+    int desl;
+    tlb_ent_t *ent = tlb_busca(self, endereco, true, &desl);
+    if (ent != NULL) {
+      self->ultimo_endereco = endereco;
+      ent->quadro[desl] = valor;
+      return ERR_OK;
+    }
+  }
   int end_fis;
-  int pagina;
-  err_t err = traduz_endereco(self, endereco, &end_fis, &pagina, NULL, NULL);
+  err_t err = traduz_pela_tabela(self, endereco, true, &end_fis);
   if (err != ERR_OK) {
     return err;
   }
-  tab_pag_muda_acessada(self->tab_pag, pagina, true);
-  tab_pag_muda_alterada(self->tab_pag, pagina, true);
   return mem_escreve(self->mem, end_fis, valor);
 }
 
+err_t mmu_espia(mmu_t *self, int endereco, int *pvalor)
+{
+  int end_fis = endereco;
+  if (self->tab_pag != NULL) {
+    err_t err = tab_pag_traduz(self->tab_pag, endereco, &end_fis,
+                               NULL, NULL, NULL);
+    if (err != ERR_OK) {
+      return err;
+    }
+  }
+  return mem_le(self->mem, end_fis, pvalor);
+}
+
+void mmu_tlb_contagem(mmu_t *self, int *pacertos, int *pfalhas,
+                      int *psalvas)
+{
+  *pacertos = self->tlb_acertos;
+  *pfalhas = self->tlb_falhas;
+  *psalvas = self->tlb_salvas;
+  self->tlb_acertos = 0;
+  self->tlb_falhas = 0;
+  self->tlb_salvas = 0;
+}
+
+int mmu_tam_pag(mmu_t *self)
+{
+  return self->tam_pag;
+}
+
+mem_t *mmu_mem(mmu_t *self)
+{
+  return self->mem;
+}
+
+void mmu_grava_traco(mmu_t *self, FILE *arq)
+{
+  self->traco = arq;
+  self->traco_cab = false;
+  self->ultimo_reg = TRACO_NENHUM;
+}
+
 int mmu_ultimo_endereco(mmu_t *self)
 {
   return self->ultimo_endereco;
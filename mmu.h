@@ -4,11 +4,14 @@
 // simulador do gerenciador de memória
 // recebe pedidos de acesso à memória virtual, traduz endereços e,
 //   se bem sucedido, repassa à memória física
-// faz a tradução usando uma tabela de páginas
+// faz a tradução usando uma tabela de páginas, e mantém as traduções
+//   mais recentes em uma TLB e as folhas da tabela percorridas mais
+//   recentemente em uma cache do percurso
 
 #include "err.h"
 #include "mem.h"
 #include "tab_pag.h"
+#include <stdio.h>
 
 // tipo opaco que representa o gerenciador de memória
 typedef struct mmu_t mmu_t;
@@ -29,6 +32,8 @@ void mmu_destroi(mmu_t *self);
 
 // muda a tabela de páginas a usar para a tradução de endereços
 //   virtuais em físicos nos próximos acessos à memória
+// as traduções das outras tabelas que estão na TLB são mantidas (cada
+//   tabela tem seu ASID)
 // se 'tab_pag' for NULL, não será feita tradução, os endereços
 //   virtuais recebidos serão repassados sem alteração à memória
 void mmu_usa_tab_pag(mmu_t *self, tab_pag_t *tab_pag);
@@ -44,8 +49,45 @@ err_t mmu_le(mmu_t *self, int endereco, int *pvalor);
 // retorna erro retornado pela tabela de páginas se o endereço não
 //   puder ser traduzido para um endereço físico ou o erro retornado
 //   pela memória se o acesso ao endereço não puder ser feito, ou ERR_OK
+// a escrita em uma página protegida retorna ERR_FALPAG (o SO distingue
+//   pela validade da página)
 err_t mmu_escreve(mmu_t *self, int endereco, int valor);
 
+// traduz o endereço virtual 'endereco' no endereço físico correspondente,
+//   colocando-o em '*pend_fis'
+// a página é marcada como acessada (e alterada, se 'escrita' for true)
+//   exatamente como em um acesso por mmu_le ou mmu_escreve
+// retorna os mesmos erros que mmu_le e mmu_escreve (inclusive ERR_END_INV
+//   se o endereço físico não existir na memória)
+err_t mmu_traduz(mmu_t *self, int endereco, bool escrita, int *pend_fis);
+
+// coloca em '*pvalor' o valor no endereço virtual 'endereco', sem
+//   nenhum efeito colateral: não altera os bits de acesso e alteração da
+//   tabela de páginas nem o último endereço traduzido
+// para uso na depuração (mostrar o estado da CPU), não em acessos da CPU
+// retorna os mesmos erros que mmu_le
+err_t mmu_espia(mmu_t *self, int endereco, int *pvalor);
+
+// coloca em '*pacertos' e '*pfalhas' o número de traduções feitas pela
+//   TLB e pela tabela de páginas desde a última chamada, e em '*psalvas'
+//   quantas entradas da TLB preenchidas antes de uma troca de tabela foram
+//   usadas depois dela (traduções que teriam que ser refeitas se a TLB
+//   fosse esvaziada na troca); zera as contagens
+void mmu_tlb_contagem(mmu_t *self, int *pacertos, int *pfalhas,
+                      int *psalvas);
+
+// retorna o tamanho das páginas da tabela em uso, 0 se não houver tabela
+int mmu_tam_pag(mmu_t *self);
+
+// retorna a memória física gerenciada pela MMU
+mem_t *mmu_mem(mmu_t *self);
+
+// passa a gravar em 'arq' cada página acessada pelos acessos traduzidos
+//   com uma tabela de páginas (o espaço de endereçamento, a página e se foi
+//   escrita), no formato descrito em traco.h; NULL para de gravar
+// o arquivo deve ficar aberto enquanto for usado pela MMU
+void mmu_grava_traco(mmu_t *self, FILE *arq);
+
 // retorna o último endereço virtual que a MMU traduziu (ou tentou traduzir)
 // função usada pelo SO para obter o endereço que causou falha de página
 int mmu_ultimo_endereco(mmu_t *self);
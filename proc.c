@@ -36,7 +36,12 @@ bool proc_list_empty(proc_list_t* self) {
 
 void proc_destroi(proc_t* self) {
     tab_pag_destroi(self->tab_pag);
-    mem_destroi(self->mem);
+    for(int i = 0; i < self->n_paginas; i++) {
+        free(self->sec[i]);
+    }
+    free(self->sec);
     cpue_destroi(self->cpue);
+    free(self->privada);
+    free(self->comp);
     free(self);
 }
\ No newline at end of file
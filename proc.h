@@ -13,6 +13,14 @@
 // Define a estrutura de um processo gerenciado pelo SO
 // E as funções de manipulação desta estrutura
 
+// máximo de páginas transferidas juntas do disco de paginação para um
+//   processo (a que causou a falha e as trazidas antecipadamente)
+#define MAX_TRANSF 8
+
+// máximo de páginas acessadas por uma instrução (a do código, a do
+//   argumento e a do dado)
+#define MAX_PRESOS 3
+
 typedef struct {
     /** Variáveis auxiliares*/
     int hora_criacao;  // processo foi criado
@@ -31,21 +39,74 @@ typedef struct {
     int bloqueios;
     int preempcoes;
     int falhas_pagina;
+    int suspensoes;
+    int substituicoes_limpas;    // páginas substituídas sem alteração
+    int substituicoes_alteradas; // páginas substituídas com alteração
+    int limpezas_fundo;          // páginas copiadas para o disco em segundo plano
+    int prebuscas_usadas;        // páginas trazidas antecipadamente e depois acessadas
+    int prebuscas_perdidas;      // páginas trazidas antecipadamente e tiradas sem acesso
+    int compartilhamentos;       // falhas resolvidas com um quadro de outro processo
+    int copias_escrita;          // cópias de páginas compartilhadas feitas por escrita
+    int paginas_zeradas;         // falhas resolvidas preenchendo o quadro com zeros
+    int tlb_acertos;
+    int tlb_falhas;
+    int tlb_salvas;
 } proc_metricas_t;
 
+// encadeamento de uma página do processo que está em um quadro
+//   compartilhado de que outro processo é o dono
+typedef struct {
+    struct proc_t* prox_usuario; // O próximo processo que usa o quadro (NULL se nenhum)
+    int ant, prox;               // Vizinhas na lista de páginas compartilhadas do processo (-1 se nenhuma)
+} pag_compartilhada_t;
+
 typedef struct proc_t {
     int id;
     int prog;
     cpu_estado_t* cpue;       // Estado da CPU do processo
     int disp;                 // Número do dispositivo (caso bloqueado por e/s)
     acesso_t acesso;          // Tipo de acesso (caso bloqueado por e/s)
-    mem_t* mem;               // Memória secundária do processo
+    int* imagem;              // Imagem do programa (em PROGRS), de onde a página é lida na primeira falha
+    const bool* zeradas;      // Páginas da imagem só com zeros (não precisam ser lidas)
+    const unsigned* espalhamentos; // Espalhamento do conteúdo de cada página da imagem
+    int tam;                  // Tamanho da imagem do programa
+    int n_paginas;            // Número de páginas em 'sec' e 'privada' (as do programa e as usadas depois dele)
+    int** sec;                // Memória secundária do processo: as páginas alteradas que saíram da memória principal (NULL se nenhuma cópia)
     
     /** Valores utilizados pelos escalonadores */
     int quantum;
     float tempo_esperado;
 
     tab_pag_t* tab_pag;       // Tabela de páginas do processo
+    int quadros;              // Primeiro quadro da lista de quadros do processo (-1 se nenhum)
+    int n_quadros;            // Número de quadros ocupados pelo processo
+    bool* privada;            // Páginas que o processo alterou (não podem mais ser compartilhadas)
+    pag_compartilhada_t* comp; // Encadeamento de cada página que está em um quadro compartilhado de outro processo
+    int compartilhadas;       // Primeira página da lista das que estão em quadros de outros processos (-1 se nenhuma)
+    int cota;                 // Número de quadros a que o processo tem direito (substituição local)
+
+    /** Páginas esperadas do disco de paginação (processo bloqueado por falha de página) */
+    int pag_espera;           // Página esperada (-1 se não está esperando página)
+    int n_espera;             // Número de páginas na transferência (a primeira é a esperada)
+    int pags_espera[MAX_TRANSF];    // Páginas na transferência
+    int quadros_espera[MAX_TRANSF]; // Quadros reservados para elas (-1 se ainda não tem)
+    int primeira_prebusca;    // Índice da primeira página trazida antecipadamente
+    int fim_espera;           // Hora em que termina a transferência
+
+    /** Quadros presos até o processo terminar a instrução que causou a falha de página */
+    int pc_falha;             // PC da instrução que causou a última falha de página
+    int n_presos;             // Número de quadros presos
+    int presos[MAX_PRESOS];   // Quadros com as páginas que a instrução já tem
+
+    /** Valores utilizados pela prebusca */
+    int ultima_falha;         // Página da última falha (-1 se nenhuma)
+    int n_residentes;         // Número de páginas na memória quando o processo foi suspenso
+    int residentes[MAX_TRANSF]; // Essas páginas (trazidas de volta quando for retomado)
+
+    /** Valores utilizados pelo controle de carga */
+    int demanda;              // Estimativa do número de quadros que o processo precisa
+    int falhas_janela;        // Falhas de página na janela de medição atual
+    int tics_janela;          // Interrupções de relógio na janela de medição atual
 
     proc_metricas_t metricas; // Métricas do processo
 
@@ -1,5 +1,4 @@
 #include <stdlib.h>
-#include <time.h>
 #include "rand.h"
 
 struct rand_t {
@@ -7,12 +6,13 @@ struct rand_t {
     int max;
     rel_t* rel;
     int n_inst_ultima_leitura;
+    unsigned semente;           // estado do gerador (rand_r)
 };
 
-rand_t *rand_cria(rel_t *rel)
+rand_t *rand_cria(rel_t *rel, unsigned semente)
 {
     rand_t* self = malloc(sizeof(rand_t));
-    srand(time(NULL));
+    self->semente = semente;
     self->min = 0;
     self->max = 1000;
     self->rel = rel;
@@ -27,9 +27,9 @@ void rand_destroi(rand_t *self)
 }
 
 // gera um número pseudo-aleatório entre min e max
-// usando a seed gerada quando o dispositivo foi iniciado
+// usando a semente dada quando o dispositivo foi iniciado
 int rand_inteiro(rand_t* self) {
-    return self->min + rand() % self->max;
+    return self->min + rand_r(&self->semente) % self->max;
 }
 
 err_t rand_le(void *disp, int id, int *pvalor)
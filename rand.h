@@ -10,9 +10,10 @@
 // Ocupado durante 10 instruções (para simular e/s)
 typedef struct rand_t rand_t;
 
-// cria e inicializa o dispositivo
+// cria e inicializa o dispositivo, com o gerador de números iniciado com
+//   'semente' (a mesma semente dá a mesma sequência de números)
 // retorna NULL em caso de erro
-rand_t *rand_cria(rel_t* rel);
+rand_t *rand_cria(rel_t* rel, unsigned semente);
 
 // destrói o dispositivo
 // nenhuma outra operação pode ser realizada no dispositivo após esta chamada
@@ -32,6 +32,19 @@ err_t rel_tictac(rel_t *self)
   return ERR_OK;
 }
 
+int rel_falta_tic(rel_t *self)
+{
+  if (self->periodo == 0) {
+    return 0;
+  }
+  return self->periodo - self->agora % self->periodo;
+}
+
+void rel_avanca(rel_t *self, int n)
+{
+  self->agora += n;
+}
+
 int rel_agora(rel_t *self)
 {
   return self->agora;
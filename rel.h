@@ -22,6 +22,14 @@ void rel_destroi(rel_t *self);
 // retorna ERR_TIC se for hora de interromper, ou ERR_OK
 err_t rel_tictac(rel_t *self);
 
+// retorna quantas chamadas a rel_tictac faltam para a próxima interrupção
+//   (contando a que retorna ERR_TIC), ou 0 se o relógio não interrompe
+int rel_falta_tic(rel_t *self);
+
+// registra a passagem de 'n' unidades de tempo de uma vez
+// 'n' deve ser menor que rel_falta_tic (a passagem não gera interrupção)
+void rel_avanca(rel_t *self, int n);
+
 // retorna a hora atual do sistema, em unidades de tempo
 int rel_agora(rel_t *self);
 
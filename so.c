@@ -3,26 +3,74 @@
 #include "proc.h"
 #include "rel.h"
 #include "so_mem.h"
+#include "alg_pag.h"
 #include "progr.h"
+#include "swap.h"
+#include "config.h"
 #include <stdlib.h>
 #include <sys/queue.h>
 #include <stdio.h>
 #include <time.h>
-
-#define PROGRAMA_INICIAL 0
-#define ESCALONADOR ROUND_ROBIN
-#define MAX_QUANTUM 2
-#define ALG_PAG FIFO
-
-typedef enum {
-  ROUND_ROBIN,
-  SHORTEST
-} escalonador_t;
-
-typedef enum {
-  ALEATORIO,       // Escolhe uma página qualquer (péssimo)
-  FIFO             // Escolhe a página mais antiga
-} alg_pag_t;
+#include <string.h>
+
+// todos os parâmetros do SO são escolhidos na execução (config.h): o
+//   programa inicial, o escalonador, o quantum, a substituição de páginas,
+//   o tamanho da memória e dos quadros e os parâmetros da paginação abaixo
+//   (entre parênteses, o nome de cada um na configuração); as opções de
+//   sim ou não da paginação vêm desligadas, e precisam ser pedidas
+
+// falhas assíncronas (falpag_assincrona): o processo que causa uma falha
+//   de página fica bloqueado enquanto a página é transferida pelo disco de
+//   paginação; senão a transferência é instantânea
+// na substituição local, nenhum processo tem cota menor que cota_min
+//   quadros (uma instrução pode acessar até 3 páginas: a do código, a do
+//   argumento e a do dado)
+
+// controle de carga (controle_carga): a frequência de falhas de página de
+//   cada processo é medida em janelas de janela_pff interrupções de relógio
+//   em que ele está executando (ou até ter mais de pff_alta falhas); com
+//   mais de pff_alta falhas na janela, estima-se que ele precisa de mais um
+//   quadro do que tem, com menos de pff_baixa, de um a menos (e nunca menos
+//   que demanda_min); quando a soma das estimativas dos processos ativos
+//   passa do número de quadros, processos prontos são suspensos (perdem
+//   todos os quadros) até haver memória para eles (a estimativa também é
+//   usada pela substituição local pff)
+// as páginas da instrução que causou uma falha de página ficam presas até
+//   o processo terminá-la, senão, com pouca memória (e sem o controle de
+//   carga), um processo pode perder uma página enquanto espera a próxima, e
+//   nenhum consegue ter ao mesmo tempo todas as páginas de uma instrução
+
+// limpeza em segundo plano (limpeza): a cada interrupção de relógio, o SO
+//   copia para o disco (quando ele não está ocupado) as páginas alteradas
+//   que estão entre os quadros ocupados há mais tempo, os que devem ser
+//   substituídos logo, para que haja pelo menos limpos_min quadros livres
+//   ou com páginas não alteradas entre eles; assim, a falha de página não
+//   precisa esperar a cópia da página substituída; com a CPU parada,
+//   adianta também a cópia das outras páginas alteradas
+
+// prebusca (prebusca_seq): numa falha de página logo depois de uma falha na
+//   página anterior (acesso sequencial), as próximas prebusca_seq páginas
+//   (no máximo MAX_TRANSF-1) são trazidas na mesma transferência, em
+//   quadros escolhidos como numa falha
+// pré-paginação (pre_paginacao): um processo suspenso, quando é retomado,
+//   traz de volta as páginas que tinha na memória antes de voltar a executar
+
+// compartilhamento (compartilha): as páginas que um processo ainda não
+//   alterou são iguais às da imagem do programa, e ficam em quadros que
+//   podem ser usados por todos os processos que têm uma página de mesmo
+//   número com o mesmo conteúdo (do mesmo programa, ou de outro com partes
+//   iguais, como grande_es_t0 e grande_es_t1); o quadro é encontrado pelo
+//   espalhamento do conteúdo da página, e o conteúdo é comparado; essas
+//   páginas ficam protegidas contra escrita, e a primeira escrita faz uma
+//   cópia só do processo (copy-on-write)
+
+// tamanho do espaço de endereçamento de um processo (max_paginas, ou as
+//   páginas do programa, se forem mais): o programa fica no início, e as
+//   páginas depois dele são zeradas no primeiro acesso (o processo pode pôr
+//   dados em qualquer lugar do espaço)
+
+// número de programas em PROGRS
+#define N_PROGRS (int)(sizeof(PROGRS)/sizeof(PROGRS[0]))
 
 /**
  * Tabela de processos do SO
@@ -31,6 +79,7 @@ typedef enum {
 typedef struct {
   proc_list_t* bloqueados;
   proc_list_t* prontos;
+  proc_list_t* suspensos; // processos sem memória, esperando para voltar
   proc_t* atual;          // processo atual em execução (NULL caso nenhum)
   int max_pid;            // último id de processo gerado
 } tab_proc_t;
@@ -50,6 +99,18 @@ typedef struct {
   int interrupcoes;
   int sisops;
   int falhas_pagina;
+  int suspensoes;
+  int substituicoes_limpas;
+  int substituicoes_alteradas;
+  int limpezas_fundo;
+  int prebuscas_usadas;
+  int prebuscas_perdidas;
+  int compartilhamentos;
+  int copias_escrita;
+  int paginas_zeradas;
+  int tlb_acertos;
+  int tlb_falhas;
+  int tlb_salvas;
 } so_metricas_t;
 
 struct so_t {
@@ -59,8 +120,22 @@ struct so_t {
   tab_proc_t processos;      // tabela de processos do SO
   so_metricas_t metricas;    // métricas do SO
   so_mem_t* so_mem;          // gerenciador de memória do SO
-  alg_pag_t alg_pag;         // algoritmo de substituição de páginas do SO
+  alg_pag_t* alg_pag;        // algoritmo de substituição de páginas do SO
+  so_subst_t subst;          // alcance da substituição de páginas
+  int n_prebuscados;         // quadros com páginas trazidas antecipadamente ainda não acessadas
+  proc_t* prioritario;       // processo que ficou sem quadro para a instrução que falhou, os outros esperam ele terminá-la (NULL se nenhum)
+  bool* zeradas[N_PROGRS];   // para cada programa, as páginas da imagem só com zeros
+  unsigned* espalhamentos[N_PROGRS]; // e o espalhamento do conteúdo de cada página
+  unsigned espalhamento_zero; // espalhamento de uma página só com zeros
   escalonador_t escalonador; // tipo de escalonador a ser utilizado
+  int max_quantum;           // interrupções de relógio por quantum
+  int quadro_tam;            // tamanho das páginas e quadros
+  int n_quadros;             // número de quadros da memória principal
+  config_t config;           // os parâmetros da paginação (e os outros)
+  tab_pag_conj_t* tab_pags;  // as tabelas de páginas dos processos
+  tela_t* tela;              // onde escrever as mensagens
+  unsigned semente;          // semente do algoritmo de substituição
+  char dir_metricas[CONFIG_NOME_TAM]; // diretório dos arquivos de métricas
 };
 
 // funções auxiliares
@@ -77,17 +152,29 @@ static proc_t* so_escalona(so_t* self);
 static void so_imprime_metricas(so_t* self);
 static void so_imprime_metricas_processo(so_t* self, proc_t* proc);
 static void so_verifica_bloqueados(so_t* self);
-
-static void so_cria_tab_proc(so_t* self) {
+static void so_controla_carga(so_t* self);
+static int so_num_paginas(proc_t* proc);
+static void so_limpa_fundo(so_t* self);
+static void so_conta_prebusca(so_t* self, int quadro);
+static void so_verifica_prebuscas(so_t* self);
+static void so_marca_paginas(so_t* self);
+static void so_solta_presos(so_t* self, proc_t* proc);
+static void so_solta_quadro(so_t* self, proc_t* proc, int quadro);
+
+static void so_cria_tab_proc(so_t* self, config_t* config) {
   self->processos.bloqueados = proc_list_cria();
   self->processos.prontos = proc_list_cria();
+  self->processos.suspensos = proc_list_cria();
   self->processos.atual = NULL;
   self->processos.max_pid = 0;
-  self->escalonador = ESCALONADOR;
+  self->escalonador = config->escalonador;
+  self->max_quantum = config->max_quantum;
 }
 
 static void so_inicializa_metricas(so_t* self) {
   self->metricas.hora_inicio = rel_agora(self->rel);
+  self->metricas.hora_bloqueio = self->metricas.hora_inicio;
+  self->metricas.hora_desbloqueio = self->metricas.hora_inicio;
   self->metricas.interrupcoes = 0;
   self->metricas.sisops = 0;
   self->metricas.tempo_total = 0;
@@ -95,21 +182,45 @@ static void so_inicializa_metricas(so_t* self) {
   self->metricas.tempo_parado = 0;
   self->metricas.hora_inicio_real = time(NULL);
   self->metricas.falhas_pagina = 0;
+  self->metricas.suspensoes = 0;
+  self->metricas.substituicoes_limpas = 0;
+  self->metricas.substituicoes_alteradas = 0;
+  self->metricas.limpezas_fundo = 0;
+  self->metricas.prebuscas_usadas = 0;
+  self->metricas.prebuscas_perdidas = 0;
+  self->metricas.compartilhamentos = 0;
+  self->metricas.copias_escrita = 0;
+  self->metricas.paginas_zeradas = 0;
+  self->metricas.tlb_acertos = 0;
+  self->metricas.tlb_falhas = 0;
+  self->metricas.tlb_salvas = 0;
 }
 
-so_t *so_cria(contr_t *contr)
+so_t *so_cria(contr_t *contr, config_t *config)
 {
   so_t *self = malloc(sizeof(*self));
   if (self == NULL) return NULL;
   self->contr = contr;
   self->paniquei = false;
   self->rel = contr_rel(self->contr);
-  self->so_mem = so_mem_cria();
+  self->tela = contr_tela(self->contr);
+  self->semente = config->semente;
+  strcpy(self->dir_metricas, config->metricas);
+  self->quadro_tam = config->quadro_tam;
+  self->n_quadros = config_num_quadros(config);
+  self->tab_pags = tab_pag_conj_cria(self->n_quadros);
+  self->so_mem = so_mem_cria(self->n_quadros);
+  self->alg_pag = alg_pag_cria(config->alg_pag, self->so_mem, self->semente);
+  self->subst = config->subst;
+  self->config = *config;
+  self->n_prebuscados = 0;
+  self->prioritario = NULL;
+  so_marca_paginas(self);
   
-  so_cria_tab_proc(self);
+  so_cria_tab_proc(self, config);
   so_inicializa_metricas(self);
 
-  so_despacha(self, so_cria_processo(self, PROGRAMA_INICIAL));
+  so_despacha(self, so_cria_processo(self, config->programa_inicial));
 
   return self;
 }
@@ -118,10 +229,30 @@ void so_destroi(so_t *self)
 {
   proc_list_destroi(self->processos.bloqueados);
   proc_list_destroi(self->processos.prontos);
+  proc_list_destroi(self->processos.suspensos);
+  alg_pag_destroi(self->alg_pag);
   so_mem_destroi(self->so_mem);
+  tab_pag_conj_destroi(self->tab_pags);
+  for(int i = 0; i < N_PROGRS; i++) {
+    free(self->zeradas[i]);
+    free(self->espalhamentos[i]);
+  }
   free(self);
 }
 
+void so_muda_alg_pag(so_t *self, alg_pag_tipo_t tipo)
+{
+  alg_pag_t* alg_pag = alg_pag_cria(tipo, self->so_mem, self->semente);
+  if(alg_pag == NULL) return;
+  alg_pag_destroi(self->alg_pag);
+  self->alg_pag = alg_pag;
+}
+
+void so_muda_subst(so_t *self, so_subst_t subst)
+{
+  self->subst = subst;
+}
+
 bool so_ok(so_t *self)
 {
   return !self->paniquei;
@@ -159,7 +290,7 @@ static void so_trata_sisop_fim(so_t *self)
 {
   int pid = self->processos.atual->id;
   so_finaliza_processo(self, self->processos.atual);
-  t_printf("Processo %d finalizado", pid);
+  t_printf(self->tela, "Processo %d finalizado", pid);
 }
 
 // chamada de sistema para criação de processo
@@ -191,68 +322,683 @@ static void so_trata_sisop(so_t *self)
       so_trata_sisop_cria(self);
       break;
     default:
-      t_printf("SO: chamada de sistema não reconhecida %d feita pelo processo %d\n", chamada, self->processos.atual->id);
+      t_printf(self->tela, "SO: chamada de sistema não reconhecida %d feita pelo processo %d\n", chamada, self->processos.atual->id);
       so_finaliza_processo(self, self->processos.atual);
   }
 }
 
+// fim de uma janela de medição da frequência de falhas do processo:
+//   reestima a sua demanda de quadros
+static void so_fecha_janela(so_t* self, proc_t* proc)
+{
+  int max = so_num_paginas(proc);
+  int demanda_min = self->config.demanda_min;
+  if(proc->falhas_janela > self->config.pff_alta && proc->demanda < max) {
+    proc->demanda = proc->n_quadros + 1;
+  } else if(proc->falhas_janela < self->config.pff_baixa && proc->demanda > demanda_min) {
+    proc->demanda--;
+  }
+  if(proc->demanda > max) proc->demanda = max;
+  if(proc->demanda < demanda_min) proc->demanda = demanda_min;
+  proc->tics_janela = 0;
+  proc->falhas_janela = 0;
+}
+
 // trata uma interrupção de tempo do relógio
 static void so_trata_tic(so_t *self)
 {
-  if(self->processos.atual == NULL) return;
+  so_verifica_prebuscas(self);
+  alg_pag_amostra(self->alg_pag);
+  if(self->config.limpeza) so_limpa_fundo(self);
+
+  proc_t* proc = self->processos.atual;
+  if(proc == NULL) return;
+
+  proc->quantum--;
+  if(++proc->tics_janela == self->config.janela_pff) so_fecha_janela(self, proc);
+}
+
+// número de páginas do processo
+static int so_num_paginas(proc_t* proc)
+{
+  return proc->n_paginas;
+}
+
+// número de posições da página que estão na imagem do programa (a última
+//   página do programa pode ser incompleta, e as depois dela não têm nada)
+static int so_tam_imagem(so_t* self, proc_t* proc, int pagina)
+{
+  int tam = proc->tam - pagina * self->quadro_tam;
+  if(tam < 0) return 0;
+  return tam < self->quadro_tam ? tam : self->quadro_tam;
+}
+
+// verifica se a página nunca foi alterada e só tem zeros: não precisa ser
+//   lida, o quadro é zerado
+static bool so_pagina_zerada(so_t* self, proc_t* proc, int pagina)
+{
+  if(proc->sec[pagina] != NULL) return false;
+  return so_tam_imagem(self, proc, pagina) == 0 || proc->zeradas[pagina];
+}
+
+// garante que a memória secundária do processo tem lugar para a página (o
+//   processo pode usar páginas depois do fim do programa)
+//   retorna false se não tiver memória para isso (os vetores que já cresceram
+//   ficam maiores, mas n_paginas não muda)
+static bool so_garante_pagina(proc_t* proc, int pagina)
+{
+  if(pagina < proc->n_paginas) return true;
+  int n = pagina + 1;
+  int** sec = realloc(proc->sec, n * sizeof(int*));
+  if(sec == NULL) return false;
+  proc->sec = sec;
+  bool* privada = realloc(proc->privada, n * sizeof(bool));
+  if(privada == NULL) return false;
+  proc->privada = privada;
+  pag_compartilhada_t* comp = realloc(proc->comp, n * sizeof(pag_compartilhada_t));
+  if(comp == NULL) return false;
+  proc->comp = comp;
+  for(int p = proc->n_paginas; p < n; p++) {
+    proc->sec[p] = NULL;
+    proc->privada[p] = false;
+    proc->comp[p].prox_usuario = NULL;
+    proc->comp[p].ant = proc->comp[p].prox = -1;
+  }
+  proc->n_paginas = n;
+  return true;
+}
+
+// espalhamento do conteúdo de uma página com as 'tam' posições de 'v' e
+//   zeros até completar 'quadro_tam'
+static unsigned so_espalha(int* v, int tam, int quadro_tam)
+{
+  unsigned h = 2166136261u;
+  for(int i = 0; i < quadro_tam; i++) {
+    h = (h ^ (unsigned)(i < tam ? v[i] : 0)) * 16777619u;
+  }
+  return h;
+}
 
-  self->processos.atual->quantum--;
+// espalhamento do conteúdo da página do processo, enquanto ela é igual à
+//   da imagem do programa
+static unsigned so_espalhamento(so_t* self, proc_t* proc, int pagina)
+{
+  if(so_tam_imagem(self, proc, pagina) == 0) return self->espalhamento_zero;
+  return proc->espalhamentos[pagina];
 }
 
-// decide qual quadro vai ser liberado
-static int so_escolhe_quadro(so_t* self) {
-  if(self->alg_pag == ALEATORIO) {
-    return rand() % N_QUADROS;
+// verifica se o quadro tem o mesmo conteúdo que a página do processo na
+//   imagem do programa
+static bool so_mesmo_conteudo(so_t* self, proc_t* proc, int pagina, int quadro)
+{
+  int* q = mem_ponteiro(contr_mem(self->contr), quadro * self->quadro_tam);
+  int tam = so_tam_imagem(self, proc, pagina);
+  if(tam > 0 && memcmp(q, proc->imagem + pagina * self->quadro_tam, tam * sizeof(int)) != 0) return false;
+  for(int i = tam; i < self->quadro_tam; i++) {
+    if(q[i] != 0) return false;
   }
+  return true;
+}
 
-  int indice_ultimo = 0;
-  quadro_t primeiro_quadro = so_mem_quadro(self->so_mem, 0);
-  for(int c=1; c<N_QUADROS; c++) {
-    if(so_mem_quadro(self->so_mem, c).posicao < primeiro_quadro.posicao) {
-      indice_ultimo = c;
+// copia a página que está no quadro para a memória do processo
+// retorna false se não tiver memória para a cópia
+static bool so_copia_quadro(so_t* self, int quadro)
+{
+  quadro_t q = so_mem_quadro(self->so_mem, quadro);
+  // a memória secundária só guarda as páginas que foram alteradas
+  int** sec = &q.proc->sec[q.pagina];
+  if(*sec == NULL) {
+    *sec = malloc(self->quadro_tam * sizeof(int));
+    if(*sec == NULL) {
+      t_printf(self->tela, "SO: sem memória secundária para a página %d do processo %d", q.pagina, q.proc->id);
+      return false;
     }
   }
+  mem_le_bloco(contr_mem(self->contr), quadro * self->quadro_tam, *sec, self->quadro_tam);
+  return true;
+}
 
-  return indice_ultimo;
+// tira a página que está no quadro da memória principal, copiando-a para a
+//   memória do processo se tiver sido alterada
+// o quadro continua ocupado (deve ser liberado ou ocupado por outra página)
+// retorna true se a página foi copiada
+static bool so_descarrega_quadro(so_t* self, int quadro)
+{
+  quadro_t antigo = so_mem_quadro(self->so_mem, quadro);
+  so_conta_prebusca(self, quadro);
+  tab_pag_muda_valida(antigo.proc->tab_pag, antigo.pagina, false);
+  // os outros processos que compartilham o quadro também perdem a página
+  //   (ela não pode ter sido alterada, está protegida)
+  proc_t* outro;
+  while((outro = so_mem_quadro(self->so_mem, quadro).outros) != NULL) {
+    tab_pag_muda_valida(outro->tab_pag, antigo.pagina, false);
+    so_mem_desreferencia(self->so_mem, quadro, outro);
+  }
+  if(tab_pag_alterada(antigo.proc->tab_pag, antigo.pagina)) {
+    // sem onde guardar a página, o conteúdo dela se perde
+    if(!so_copia_quadro(self, quadro)) panico(self);
+    antigo.proc->metricas.substituicoes_alteradas++;
+    self->metricas.substituicoes_alteradas++;
+    return true;
+  } else {
+    // a cópia na memória do processo está atualizada
+    antigo.proc->metricas.substituicoes_limpas++;
+    self->metricas.substituicoes_limpas++;
+    return false;
+  }
 }
 
-// trata uma falha de página
-static void so_trata_falpag(so_t* self)
+// copia para o disco a página alterada que está no quadro, sem tirá-la da
+//   memória (ela passa a não estar mais alterada)
+// retorna false se o disco de paginação está ocupado ou não tem memória para a
+//   cópia
+static bool so_limpa_quadro(so_t* self, int quadro)
 {
-  proc_t* proc = self->processos.atual;
-  tab_pag_t* tab_pag = proc->tab_pag;
-  int end = mmu_ultimo_endereco(contr_mmu(self->contr));
-  int pagina = end / QUADRO_TAM;
-  int quadro = so_mem_encontra_livre(self->so_mem);
+  es_t* es = contr_es(self->contr);
+  if(!es_pronto(es, SWAP_DISP, escrita)) return false;
+
+  quadro_t q = so_mem_quadro(self->so_mem, quadro);
+  // sem onde guardar, a página continua alterada na memória principal
+  if(!so_copia_quadro(self, quadro)) return false;
+  tab_pag_muda_alterada(q.proc->tab_pag, q.pagina, false);
+  es_escreve(es, SWAP_DISP, 1);
+  q.proc->metricas.limpezas_fundo++;
+  self->metricas.limpezas_fundo++;
+  return true;
+}
 
-  if(quadro == -1) { // Nenhum quadro disponível, troca
-    quadro = so_escolhe_quadro(self);
-    quadro_t antigo = so_mem_quadro(self->so_mem, quadro);
-    tab_pag_muda_valida(antigo.proc->tab_pag, antigo.pagina, false);
-    for(int c=0; c<QUADRO_TAM; c++) { // copia a memória do quadro para o processo
-      int val;
-      mem_le(contr_mem(self->contr), quadro * QUADRO_TAM + c, &val);
-      mem_escreve(antigo.proc->mem, antigo.pagina * QUADRO_TAM + c, val);
+// limpeza em segundo plano
+static void so_limpa_fundo(so_t* self)
+{
+  int faltam = self->config.limpos_min - so_mem_num_livres(self->so_mem);
+  bool ocioso = self->processos.atual == NULL;
+  for(int quadro = so_mem_mais_antigo(self->so_mem);
+      quadro != -1 && (faltam > 0 || ocioso);
+      quadro = so_mem_quadro(self->so_mem, quadro).prox) {
+    quadro_t q = so_mem_quadro(self->so_mem, quadro);
+    if(q.presos > 0) continue;
+    if(tab_pag_alterada(q.proc->tab_pag, q.pagina)) {
+      // uma cópia por vez, o disco fica ocupado com ela
+      so_limpa_quadro(self, quadro);
+      return;
     }
+    faltam--;
   }
+}
 
-  for(int c=0; c<QUADRO_TAM; c++) { // copia a memória do processo para o quadro
-    int val;
-    mem_le(proc->mem, pagina * QUADRO_TAM + c, &val);
-    mem_escreve(contr_mem(self->contr), quadro * QUADRO_TAM + c, val);
+// peso de um processo na divisão dos quadros entre os processos ativos
+static int so_peso_cota(so_t* self, proc_t* proc)
+{
+  switch(self->subst) {
+    case SUBST_LOCAL_PROPORCIONAL:
+      return so_num_paginas(proc);
+    case SUBST_LOCAL_PFF:
+      return proc->demanda;
+    default:
+      return 1;
   }
+}
+
+// calcula a cota de um processo, sua parte dos quadros de acordo com seu
+//   peso (arredondando para cima, e no mínimo cota_min)
+static void so_calcula_cota(so_t* self, proc_t* proc, int peso_total)
+{
+  proc->cota = (self->n_quadros * so_peso_cota(self, proc) + peso_total - 1) / peso_total;
+  if(proc->cota < self->config.cota_min) proc->cota = self->config.cota_min;
+}
+
+// divide os quadros entre os processos ativos
+static void so_calcula_cotas(so_t* self)
+{
+  proc_t* atual = self->processos.atual;
+  proc_t* el;
+  int peso_total = 0;
+  if(atual != NULL) peso_total += so_peso_cota(self, atual);
+  STAILQ_FOREACH(el, self->processos.prontos, entries) peso_total += so_peso_cota(self, el);
+  STAILQ_FOREACH(el, self->processos.bloqueados, entries) peso_total += so_peso_cota(self, el);
+  if(peso_total == 0) return;
+
+  if(atual != NULL) so_calcula_cota(self, atual, peso_total);
+  STAILQ_FOREACH(el, self->processos.prontos, entries) so_calcula_cota(self, el, peso_total);
+  STAILQ_FOREACH(el, self->processos.bloqueados, entries) so_calcula_cota(self, el, peso_total);
+}
+
+// retorna o processo com mais quadros além da cota entre 'dono' e 'proc'
+//   (que deve ter algum quadro para ser considerado)
+static proc_t* so_maior_excesso(proc_t* dono, proc_t* proc)
+{
+  if(proc->n_quadros == 0) return dono;
+  if(dono == NULL || proc->n_quadros - proc->cota > dono->n_quadros - dono->cota) return proc;
+  return dono;
+}
+
+// escolhe o processo que vai perder um quadro para 'proc', na substituição
+//   local quando 'proc' está abaixo da cota: o que tem mais quadros além da
+//   sua cota
+static proc_t* so_escolhe_dono(so_t* self, proc_t* proc)
+{
+  proc_t* dono = NULL;
+  proc_t* el;
+  STAILQ_FOREACH(el, self->processos.prontos, entries) dono = so_maior_excesso(dono, el);
+  STAILQ_FOREACH(el, self->processos.bloqueados, entries) dono = so_maior_excesso(dono, el);
+  return dono != NULL ? dono : proc;
+}
+
+// decide em que quadro vai ser colocada uma página do processo 'proc'
+// retorna um quadro livre ou o quadro escolhido para ser substituído
+static int so_escolhe_quadro(so_t* self, proc_t* proc)
+{
+  int quadro = so_mem_encontra_livre(self->so_mem);
+  if(self->subst == SUBST_GLOBAL) {
+    if(quadro == -1) quadro = alg_pag_escolhe(self->alg_pag, NULL);
+    return quadro;
+  }
+
+  // substituição local: se o processo já tem sua cota, substitui uma das
+  //   suas páginas; senão, usa um quadro livre ou tira de outro processo
+  so_calcula_cotas(self);
+  if(proc->n_quadros > 0 && proc->n_quadros >= proc->cota) {
+    int proprio = alg_pag_escolhe(self->alg_pag, proc);
+    // se os quadros do processo estão todos presos (pela instrução que ele
+    //   está executando), tira de outro, mesmo passando da cota
+    if(proprio != -1) return proprio;
+  }
+  if(quadro == -1) {
+    quadro = alg_pag_escolhe(self->alg_pag, so_escolhe_dono(self, proc));
+  }
+  if(quadro == -1) quadro = alg_pag_escolhe(self->alg_pag, NULL);
+  return quadro;
+}
+
+// reserva um quadro para a página 'pagina' do processo, tirando a página
+//   que estiver nele
+// retorna o quadro, ou -1 se não há quadro disponível (estão todos presos)
+// coloca em '*ptransf' o número de páginas a transferir do/para o disco
+static int so_reserva_quadro(so_t* self, proc_t* proc, int pagina, int *ptransf)
+{
+  // enquanto o processo prioritário não termina a instrução, os outros não
+  //   pegam quadros
+  if(self->prioritario != NULL && self->prioritario != proc) return -1;
+  int quadro = so_escolhe_quadro(self, proc);
+  if(quadro == -1) return -1;
+
+  *ptransf = 1;
+  if(!so_mem_quadro(self->so_mem, quadro).livre) { // troca
+    if(so_descarrega_quadro(self, quadro)) (*ptransf)++;
+  }
+  so_mem_ocupa(self->so_mem, quadro, proc, pagina);
+  return quadro;
+}
+
+// coloca no quadro reservado a página 'pagina' do processo
+// 'prebusca' diz se a página foi trazida antecipadamente (não foi ela que
+//   causou a falha)
+static void so_carrega_pagina(so_t* self, proc_t* proc, int pagina, int quadro, bool prebusca)
+{
+  tab_pag_t* tab_pag = proc->tab_pag;
+
+  // copia a página para o quadro: da memória secundária se ela já foi
+  //   alterada, senão da imagem do programa; o que não está na imagem (ou
+  //   uma página só com zeros) não precisa ser lido, é zerado
+  int* orig = proc->sec[pagina];
+  int tam = self->quadro_tam;
+  if(orig == NULL) {
+    orig = proc->imagem + pagina * self->quadro_tam;
+    tam = so_pagina_zerada(self, proc, pagina) ? 0 : so_tam_imagem(self, proc, pagina);
+  }
+  mem_escreve_bloco(contr_mem(self->contr), quadro * self->quadro_tam, orig, tam);
+  if(tam < self->quadro_tam) {
+    memset(mem_ponteiro(contr_mem(self->contr), quadro * self->quadro_tam + tam), 0,
+           (self->quadro_tam - tam) * sizeof(int));
+  }
+  // o conteúdo do quadro mudou, as instruções decodificadas não valem mais
+  exec_invalida(contr_exec(self->contr), quadro * self->quadro_tam, self->quadro_tam);
 
   tab_pag_muda_quadro(tab_pag, pagina, quadro);
   tab_pag_muda_valida(tab_pag, pagina, true);
-  so_mem_ocupa(self->so_mem, quadro, proc, pagina);
+  // o quadro é igual à cópia na memória do processo; a página que causou a
+  //   falha conta como acessada porque o acesso vai ser refeito (se o
+  //   processo esperou por ela, ela não pode parecer a melhor vítima antes
+  //   disso); uma trazida antecipadamente só é acessada se for usada
+  tab_pag_muda_alterada(tab_pag, pagina, false);
+  tab_pag_muda_acessada(tab_pag, pagina, !prebusca);
+  // uma página que o processo não alterou é igual à do programa, pode ser
+  //   compartilhada (e fica protegida até ser alterada)
+  bool compartilhavel = self->config.compartilha && !proc->privada[pagina];
+  tab_pag_muda_protegida(tab_pag, pagina, compartilhavel);
+  if(compartilhavel) {
+    so_mem_compartilha(self->so_mem, quadro, true, so_espalhamento(self, proc, pagina));
+  }
+  alg_pag_carregou(self->alg_pag, quadro);
+  if(prebusca) {
+    so_mem_marca_prebuscado(self->so_mem, quadro, true);
+    self->n_prebuscados++;
+  }
+}
+
+// se outro processo tem na memória uma página (não alterada) de mesmo
+//   número e com o mesmo conteúdo, passa a usar o mesmo quadro
+// retorna false se não há quadro para compartilhar
+static bool so_compartilha_pagina(so_t* self, proc_t* proc, int pagina)
+{
+  if(!self->config.compartilha || proc->privada[pagina]) return false;
+  unsigned espalhamento = so_espalhamento(self, proc, pagina);
+  int quadro = -1;
+  do {
+    quadro = so_mem_encontra_compartilhado(self->so_mem, espalhamento, pagina, quadro);
+    if(quadro == -1) return false;
+  } while(!so_mesmo_conteudo(self, proc, pagina, quadro));
+
+  so_mem_referencia(self->so_mem, quadro, proc);
+  tab_pag_t* tab_pag = proc->tab_pag;
+  tab_pag_muda_quadro(tab_pag, pagina, quadro);
+  tab_pag_muda_valida(tab_pag, pagina, true);
+  tab_pag_muda_protegida(tab_pag, pagina, true);
+  tab_pag_muda_alterada(tab_pag, pagina, false);
+  tab_pag_muda_acessada(tab_pag, pagina, true);
+  proc->metricas.compartilhamentos++;
+  self->metricas.compartilhamentos++;
+  return true;
+}
+
+// o processo deixa de usar a página que está na memória: se outros
+//   processos compartilham o quadro, ele continua com eles; senão, o quadro
+//   é liberado (copiando a página para a memória do processo se
+//   'descarrega' e ela foi alterada)
+static void so_desmapeia(so_t* self, proc_t* proc, int pagina, bool descarrega)
+{
+  int quadro = tab_pag_quadro(proc->tab_pag, pagina);
+  so_solta_quadro(self, proc, quadro);
+  quadro_t q = so_mem_quadro(self->so_mem, quadro);
+  if(q.refs > 1) {
+    so_mem_desreferencia(self->so_mem, quadro, proc);
+    tab_pag_muda_valida(proc->tab_pag, pagina, false);
+    return;
+  }
+  if(descarrega) {
+    so_descarrega_quadro(self, quadro);
+  } else {
+    so_conta_prebusca(self, quadro);
+  }
+  so_mem_libera(self->so_mem, quadro);
+  alg_pag_liberou(self->alg_pag, quadro);
+}
+
+// coloca a página em um quadro sem esperar o disco de paginação (o
+//   conteúdo não vem do disco)
+// retorna false se não há quadro para a página
+static bool so_carrega_sem_disco(so_t* self, proc_t* proc, int pagina)
+{
+  int transf;
+  int quadro = so_reserva_quadro(self, proc, pagina, &transf);
+  if(quadro == -1) return false;
+  if(self->config.falpag_assincrona && transf > 1) {
+    // a página tirada do quadro foi alterada, o disco fica ocupado
+    //   copiando-a
+    es_escreve(contr_es(self->contr), SWAP_DISP, transf - 1);
+  }
+  so_carrega_pagina(self, proc, pagina, quadro, false);
+  return true;
+}
+
+// uma página que nunca foi alterada e é só de zeros na imagem do programa
+//   é colocada em um quadro zerado, sem esperar o disco
+// retorna false se a página não é assim ou se não há quadro para ela
+static bool so_zera_pagina(so_t* self, proc_t* proc, int pagina)
+{
+  if(!so_pagina_zerada(self, proc, pagina)) return false;
+  if(!so_carrega_sem_disco(self, proc, pagina)) return false;
+  proc->metricas.paginas_zeradas++;
+  self->metricas.paginas_zeradas++;
+  return true;
+}
 
+// trata uma escrita em uma página protegida: o processo passa a ter a
+//   página só para ele, copiando-a para outro quadro se outros processos
+//   usam o quadro
+// retorna false se não há quadro para a cópia (a página fica inválida e
+//   deve ser trazida como em uma falha)
+static bool so_copia_na_escrita(so_t* self, proc_t* proc, int pagina)
+{
+  int quadro = tab_pag_quadro(proc->tab_pag, pagina);
+  proc->privada[pagina] = true;
+  if(so_mem_quadro(self->so_mem, quadro).refs == 1) {
+    so_mem_compartilha(self->so_mem, quadro, false, 0);
+    tab_pag_muda_protegida(proc->tab_pag, pagina, false);
+    return true;
+  }
+
+  // a página compartilhada não foi alterada, é igual à da imagem do
+  //   programa; a cópia é feita entre quadros, sem esperar o disco
+  so_desmapeia(self, proc, pagina, false);
+  if(!so_carrega_sem_disco(self, proc, pagina)) return false;
+  proc->metricas.copias_escrita++;
+  self->metricas.copias_escrita++;
+  return true;
+}
+
+// contabiliza o uso de uma página trazida antecipadamente que foi acessada
+//   ou que vai sair da memória
+static void so_conta_prebusca(so_t* self, int quadro)
+{
+  quadro_t q = so_mem_quadro(self->so_mem, quadro);
+  if(!q.prebuscado) return;
+  if(tab_pag_acessada(q.proc->tab_pag, q.pagina)) {
+    q.proc->metricas.prebuscas_usadas++;
+    self->metricas.prebuscas_usadas++;
+  } else {
+    q.proc->metricas.prebuscas_perdidas++;
+    self->metricas.prebuscas_perdidas++;
+  }
+  so_mem_marca_prebuscado(self->so_mem, quadro, false);
+  self->n_prebuscados--;
+}
+
+// verifica quais páginas trazidas antecipadamente foram acessadas (antes
+//   que o algoritmo de substituição desligue os bits de acesso)
+static void so_verifica_prebuscas(so_t* self)
+{
+  for(int quadro = so_mem_mais_antigo(self->so_mem);
+      quadro != -1 && self->n_prebuscados > 0;
+      quadro = so_mem_quadro(self->so_mem, quadro).prox) {
+    quadro_t q = so_mem_quadro(self->so_mem, quadro);
+    if(q.prebuscado && tab_pag_acessada(q.proc->tab_pag, q.pagina)) {
+      so_conta_prebusca(self, quadro);
+    }
+  }
+}
+
+// prende o quadro com uma página que a instrução que causou a falha de
+//   página do processo usa, até ele terminar a instrução: senão, com pouca
+//   memória, a página pode ser substituída enquanto o processo espera a
+//   próxima que a instrução usa, e ele nunca consegue ter todas ao mesmo
+//   tempo
+static void so_prende_instrucao(so_t* self, proc_t* proc, int quadro)
+{
+  for(int i = 0; i < proc->n_presos; i++) {
+    if(proc->presos[i] == quadro) return;
+  }
+  so_mem_prende(self->so_mem, quadro, true);
+  proc->presos[proc->n_presos++] = quadro;
+}
+
+// solta os quadros presos pela instrução do processo
+static void so_solta_presos(so_t* self, proc_t* proc)
+{
+  for(int i = 0; i < proc->n_presos; i++) {
+    so_mem_prende(self->so_mem, proc->presos[i], false);
+  }
+  proc->n_presos = 0;
+}
+
+// o processo terminou a instrução que causou a falha de página (ou não vai
+//   mais executá-la): solta os quadros dela e deixa de ter prioridade
+static void so_termina_instrucao(so_t* self, proc_t* proc)
+{
+  so_solta_presos(self, proc);
+  if(self->prioritario == proc) self->prioritario = NULL;
+}
+
+// solta o quadro, se estiver preso pela instrução do processo
+static void so_solta_quadro(so_t* self, proc_t* proc, int quadro)
+{
+  for(int i = 0; i < proc->n_presos; i++) {
+    if(proc->presos[i] == quadro) {
+      so_mem_prende(self->so_mem, quadro, false);
+      proc->presos[i] = proc->presos[--proc->n_presos];
+      return;
+    }
+  }
+}
+
+// prepara a espera do processo pelas páginas 'pags', a primeira sendo a
+//   esperada e a partir de 'primeira_prebusca' as trazidas antecipadamente
+static void so_prepara_espera(proc_t* proc, int *pags, int n, int primeira_prebusca)
+{
+  for(int i = 0; i < n; i++) {
+    proc->pags_espera[i] = pags[i];
+    proc->quadros_espera[i] = -1;
+  }
+  proc->n_espera = n;
+  proc->pag_espera = pags[0];
+  proc->primeira_prebusca = primeira_prebusca;
+}
+
+// tenta iniciar a transferência das páginas que o processo espera: reserva
+//   os quadros (que ficam presos até o fim da transferência) e faz o pedido
+//   ao disco de paginação, um só para todas as páginas
+// as páginas trazidas antecipadamente que não conseguem quadro (estão
+//   todos presos) não são trazidas
+// retorna false se não há quadro disponível para a página esperada
+// para que processos esperando páginas não fiquem esperando uns pelos
+//   quadros presos pelos outros, o primeiro que fica sem quadro passa a ter
+//   prioridade: mantém os seus quadros presos e os outros não reservam
+//   quadros até ele terminar a instrução; os outros que ficam sem quadro
+//   soltam os seus
+static bool so_inicia_paginacao(so_t* self, proc_t* proc)
+{
+  int n = 0, transf_total = 0;
+  for(int i = 0; i < proc->n_espera; i++) {
+    int pagina = proc->pags_espera[i];
+    int transf;
+    int quadro = so_reserva_quadro(self, proc, pagina, &transf);
+    if(quadro == -1) {
+      if(i == 0) {
+        if(self->prioritario == NULL) {
+          self->prioritario = proc;
+        } else if(self->prioritario != proc) {
+          so_solta_presos(self, proc);
+        }
+        return false;
+      }
+      break;
+    }
+    so_mem_prende(self->so_mem, quadro, true);
+    proc->pags_espera[n] = pagina;
+    proc->quadros_espera[n] = quadro;
+    n++;
+    transf_total += transf;
+  }
+  proc->n_espera = n;
+
+  if(self->config.falpag_assincrona) {
+    es_escreve(contr_es(self->contr), SWAP_DISP, transf_total);
+    es_le(contr_es(self->contr), SWAP_DISP, &proc->fim_espera);
+  } else {
+    proc->fim_espera = rel_agora(self->rel);
+  }
+  return true;
+}
+
+// verifica se a transferência das páginas que o processo espera terminou
+//   (iniciando-a, se ainda não foi possível), e nesse caso coloca as páginas
+//   na memória
+// retorna true se as páginas estão na memória
+static bool so_termina_paginacao(so_t* self, proc_t* proc)
+{
+  if(proc->quadros_espera[0] == -1 && !so_inicia_paginacao(self, proc)) return false;
+  if(rel_agora(self->rel) < proc->fim_espera) return false;
+
+  for(int i = 0; i < proc->n_espera; i++) {
+    int quadro = proc->quadros_espera[i];
+    so_mem_prende(self->so_mem, quadro, false);
+    so_carrega_pagina(self, proc, proc->pags_espera[i], quadro,
+                      i >= proc->primeira_prebusca);
+    // a página que causou a falha continua presa até ser usada
+    if(i < proc->primeira_prebusca) so_prende_instrucao(self, proc, quadro);
+  }
+  proc->pag_espera = -1;
+  proc->n_espera = 0;
+  return true;
+}
+
+// trata uma falha de página
+static void so_trata_falpag(so_t* self)
+{
+  proc_t* proc = self->processos.atual;
+  int end = mmu_ultimo_endereco(contr_mmu(self->contr));
+  int pagina = end / self->quadro_tam;
+  if(!so_garante_pagina(proc, pagina)) {
+    t_printf(self->tela, "SO: sem memória para a página %d do processo %d", pagina, proc->id);
+    so_finaliza_processo(self, proc);
+    return;
+  }
+  // a instrução já teve todas as páginas que pode acessar e falhou de novo
+  //   no mesmo PC: foi executada (desvia para ela mesma), essas páginas não
+  //   precisam mais ficar presas
+  if(proc->n_presos == MAX_PRESOS) so_solta_presos(self, proc);
+  proc->pc_falha = cpue_PC(proc->cpue);
+  // as páginas da instrução que já estão na memória (a do código e a do
+  //   argumento, se a falha não foi nelas) ficam presas com a que falta
+  for(int end_instr = proc->pc_falha; end_instr <= proc->pc_falha + 1; end_instr++) {
+    int pag = end_instr / self->quadro_tam;
+    if(pag != pagina && pag < so_num_paginas(proc) && tab_pag_valida(proc->tab_pag, pag)) {
+      so_prende_instrucao(self, proc, tab_pag_quadro(proc->tab_pag, pag));
+    }
+  }
+
+  // a página está na memória: foi uma escrita em página protegida;
+  //   se não, talvez outro processo já tenha a página
+  bool resolvida;
+  if(tab_pag_valida(proc->tab_pag, pagina)) {
+    resolvida = so_copia_na_escrita(self, proc, pagina);
+  } else {
+    resolvida = so_compartilha_pagina(self, proc, pagina)
+                || so_zera_pagina(self, proc, pagina);
+  }
+  if(resolvida) {
+    so_prende_instrucao(self, proc, tab_pag_quadro(proc->tab_pag, pagina));
+    return;
+  }
+
+  // com mais de pff_alta falhas a janela já pode ser fechada (com falhas
+  //   assíncronas o processo quase não executa, e a janela demoraria a acabar)
+  if(++proc->falhas_janela > self->config.pff_alta) so_fecha_janela(self, proc);
   proc->metricas.falhas_pagina++;
   self->metricas.falhas_pagina++;
+
+  // falha na página seguinte à da última falha: acesso sequencial, traz
+  //   também as próximas páginas que não estão na memória
+  int pags[MAX_TRANSF];
+  int n = 0;
+  pags[n++] = pagina;
+  if(pagina == proc->ultima_falha + 1) {
+    int max = so_num_paginas(proc);
+    for(int p = pagina + 1; p <= pagina + self->config.prebusca_seq && p < max && n < MAX_TRANSF; p++) {
+      if(tab_pag_valida(proc->tab_pag, p)) continue;
+      if(!so_compartilha_pagina(self, proc, p)) pags[n++] = p;
+    }
+  }
+  proc->ultima_falha = pagina;
+  so_prepara_espera(proc, pags, n, 1);
+
+  // sem falhas assíncronas, a transferência termina na hora
+  if(!self->config.falpag_assincrona && so_termina_paginacao(self, proc)) return;
+
+  // o processo fica bloqueado até as páginas chegarem (é verificado junto
+  //   com os outros bloqueados)
+  if(self->config.falpag_assincrona) so_inicia_paginacao(self, proc);
+  so_bloqueia_processo(self);
 }
 
 // houve uma interrupção do tipo err — trate-a
@@ -261,10 +1007,29 @@ void so_int(so_t *self, err_t err)
   self->metricas.interrupcoes++;
   proc_t* proc = self->processos.atual;
 
+  // contabiliza os acessos à TLB desde a última interrupção
+  int acertos, falhas, salvas;
+  mmu_tlb_contagem(contr_mmu(self->contr), &acertos, &falhas, &salvas);
+  self->metricas.tlb_acertos += acertos;
+  self->metricas.tlb_falhas += falhas;
+  self->metricas.tlb_salvas += salvas;
+  if(proc != NULL) {
+    proc->metricas.tlb_acertos += acertos;
+    proc->metricas.tlb_falhas += falhas;
+    proc->metricas.tlb_salvas += salvas;
+  }
+
   if(proc != NULL) { // Salva o estado do processo atual
     exec_copia_estado(contr_exec(self->contr), proc->cpue);
   }
 
+  // o processo terminou a instrução que causou a última falha de página
+  //   (fez uma chamada de sistema ou está em outra instrução): as páginas
+  //   que ela usa não precisam mais ficar presas
+  if(proc != NULL && (err == ERR_SISOP || cpue_PC(proc->cpue) != proc->pc_falha)) {
+    so_termina_instrucao(self, proc);
+  }
+
   switch (err) {
     case ERR_SISOP:
       so_trata_sisop(self);
@@ -276,13 +1041,14 @@ void so_int(so_t *self, err_t err)
       so_trata_falpag(self);
       break;
     case ERR_PAGINV:
-      t_printf("Página inválida: %d", mmu_ultimo_endereco(contr_mmu(self->contr)));
+      t_printf(self->tela, "Página inválida: %d", mmu_ultimo_endereco(contr_mmu(self->contr)));
     default:
-      t_printf("SO: interrupção não tratada [%s] feita pelo processo %d", err_nome(err), proc->id);
+      t_printf(self->tela, "SO: interrupção não tratada [%s] feita pelo processo %d", err_nome(err), proc->id);
       so_finaliza_processo(self, proc);
   }
 
   so_verifica_bloqueados(self);
+  if(self->config.controle_carga) so_controla_carga(self);
   proc = so_escalona(self);
 
   so_despacha(self, proc);
@@ -315,10 +1081,122 @@ static bool so_resolve_es(so_t* self, proc_t* proc) {
 */
 static void so_verifica_bloqueados(so_t* self)
 {
+  proc_t* el = STAILQ_FIRST(self->processos.bloqueados);
+
+  while(el != NULL) {
+    // o desbloqueio muda o encadeamento de 'el'
+    proc_t* prox = STAILQ_NEXT(el, entries);
+    bool pronto;
+    if(el->pag_espera != -1) {
+      pronto = so_termina_paginacao(self, el);
+    } else {
+      pronto = so_resolve_es(self, el);
+    }
+    if(pronto) so_desbloqueia_processo(self, el);
+    el = prox;
+  }
+}
+
+// soma das demandas de memória dos processos ativos (não suspensos)
+static int so_demanda_ativa(so_t* self)
+{
+  int demanda = 0;
   proc_t* el;
+  if(self->processos.atual != NULL) demanda += self->processos.atual->demanda;
+  STAILQ_FOREACH(el, self->processos.prontos, entries) demanda += el->demanda;
+  STAILQ_FOREACH(el, self->processos.bloqueados, entries) demanda += el->demanda;
+  return demanda;
+}
 
-  STAILQ_FOREACH(el, self->processos.bloqueados, entries){
-    if(so_resolve_es(self, el)) so_desbloqueia_processo(self, el);
+// conta os processos que vão usar a CPU sem depender de um evento externo:
+//   o atual, os prontos e os bloqueados esperando uma página
+static int so_num_executaveis(so_t* self)
+{
+  int n = 0;
+  proc_t* el;
+  if(self->processos.atual != NULL) n++;
+  STAILQ_FOREACH(el, self->processos.prontos, entries) n++;
+  STAILQ_FOREACH(el, self->processos.bloqueados, entries) {
+    if(el->pag_espera != -1) n++;
+  }
+  return n;
+}
+
+// suspende um processo pronto: tira todas as suas páginas da memória
+static void so_suspende_processo(so_t* self, proc_t* proc)
+{
+  proc_list_pop(self->processos.prontos, proc);
+  proc_list_push_back(self->processos.suspensos, proc);
+  so_termina_instrucao(self, proc);
+  proc->n_residentes = 0;
+  int n = so_num_paginas(proc);
+  for(int pagina = 0; pagina < n; pagina++) {
+    if(!tab_pag_valida(proc->tab_pag, pagina)) continue;
+    if(proc->n_residentes < MAX_TRANSF) {
+      proc->residentes[proc->n_residentes++] = pagina;
+    }
+    so_desmapeia(self, proc, pagina, true);
+  }
+  proc->tics_janela = 0;
+  proc->falhas_janela = 0;
+  proc->metricas.suspensoes++;
+  self->metricas.suspensoes++;
+}
+
+// volta um processo suspenso para a fila de prontos
+// com pré-paginação, o processo antes espera bloqueado que as páginas que
+//   tinha na memória quando foi suspenso voltem; senão, elas voltam à
+//   memória por demanda
+static void so_retoma_processo(so_t* self, proc_t* proc)
+{
+  proc_list_pop(self->processos.suspensos, proc);
+  // as páginas que outro processo tem na memória são compartilhadas
+  int n = 0;
+  for(int i = 0; i < proc->n_residentes; i++) {
+    int pagina = proc->residentes[i];
+    if(!so_compartilha_pagina(self, proc, pagina)) proc->residentes[n++] = pagina;
+  }
+  proc->n_residentes = n;
+  if(self->config.pre_paginacao && proc->n_residentes > 0) {
+    so_prepara_espera(proc, proc->residentes, proc->n_residentes, 0);
+    proc->n_residentes = 0;
+    if(!so_termina_paginacao(self, proc)) {
+      proc_list_push_back(self->processos.bloqueados, proc);
+      proc->metricas.hora_bloqueio = rel_agora(self->rel);
+      return;
+    }
+  }
+  proc_list_push_back(self->processos.prontos, proc);
+}
+
+/**
+ * Escalonador de médio prazo: suspende processos quando a memória não é
+ * suficiente para a demanda dos processos ativos (para evitar que o sistema
+ * passe o tempo tratando falhas de página), e retoma quando houver memória
+*/
+static void so_controla_carga(so_t* self)
+{
+  // suspende o processo pronto com maior demanda enquanto faltar memória,
+  //   mas deixa pelo menos um outro processo que possa executar (um
+  //   processo bloqueado por E/S não conta, senão o único executável
+  //   seria suspenso logo depois de receber a página que esperava)
+  while(so_demanda_ativa(self) > self->n_quadros) {
+    proc_t *el, *maior = NULL;
+    STAILQ_FOREACH(el, self->processos.prontos, entries) {
+      if(maior == NULL || el->demanda > maior->demanda) maior = el;
+    }
+    if(maior == NULL || so_num_executaveis(self) < 2) break;
+    so_suspende_processo(self, maior);
+  }
+
+  // retoma os suspensos (na ordem em que foram suspensos) que couberem;
+  //   se não houver nenhum processo que possa executar (nem esperando
+  //   página), retoma o primeiro de qualquer forma
+  while(!proc_list_empty(self->processos.suspensos)) {
+    proc_t* proc = STAILQ_FIRST(self->processos.suspensos);
+    bool ocioso = so_num_executaveis(self) == 0;
+    if(!ocioso && so_demanda_ativa(self) + proc->demanda > self->n_quadros) break;
+    so_retoma_processo(self, proc);
   }
 }
 
@@ -332,8 +1210,10 @@ static proc_t* so_escalona(so_t* self)
   bool nenhumPronto = proc_list_empty(self->processos.prontos);
   bool nenhumBloqueado = proc_list_empty(self->processos.bloqueados);
 
-  if(nenhumPronto && nenhumBloqueado && atual == NULL) {
-    t_printf("SO: Nenhum processo disponível para o escalonador");
+  bool nenhumSuspenso = proc_list_empty(self->processos.suspensos);
+
+  if(nenhumPronto && nenhumBloqueado && nenhumSuspenso && atual == NULL) {
+    t_printf(self->tela, "SO: Nenhum processo disponível para o escalonador");
     panico(self);
     return NULL;
   }
@@ -349,7 +1229,7 @@ static proc_t* so_escalona(so_t* self)
     so_encontra_shortest(self);
   
   int agora = rel_agora(self->rel);
-  proc->quantum = MAX_QUANTUM;
+  proc->quantum = self->max_quantum;
   
   if(atual != NULL) {
     atual->metricas.preempcoes++;
@@ -381,13 +1261,52 @@ static void so_inicializa_metricas_proc(so_t* self, proc_t* proc) {
   proc->metricas.preempcoes = 0;
   proc->metricas.foi_bloqueado = false;
   proc->metricas.falhas_pagina = 0;
+  proc->metricas.suspensoes = 0;
+  proc->metricas.substituicoes_limpas = 0;
+  proc->metricas.substituicoes_alteradas = 0;
+  proc->metricas.limpezas_fundo = 0;
+  proc->metricas.prebuscas_usadas = 0;
+  proc->metricas.prebuscas_perdidas = 0;
+  proc->metricas.compartilhamentos = 0;
+  proc->metricas.copias_escrita = 0;
+  proc->metricas.paginas_zeradas = 0;
+  proc->metricas.tlb_acertos = 0;
+  proc->metricas.tlb_falhas = 0;
+  proc->metricas.tlb_salvas = 0;
+}
+
+// marca, para cada programa, as páginas da imagem que só têm zeros (as
+//   regiões reservadas com ESPACO), que não precisam ser lidas na falha, e
+//   calcula o espalhamento do conteúdo das páginas, para encontrar páginas
+//   iguais para compartilhar
+static void so_marca_paginas(so_t* self)
+{
+  self->espalhamento_zero = so_espalha(NULL, 0, self->quadro_tam);
+  for(int prog = 0; prog < N_PROGRS; prog++) {
+    int tam = PROGRS_SIZE[prog]/sizeof(PROGRS[prog][0]);
+    int n = (tam + self->quadro_tam - 1) / self->quadro_tam;
+    self->zeradas[prog] = malloc(n * sizeof(bool));
+    self->espalhamentos[prog] = malloc(n * sizeof(unsigned));
+    for(int pagina = 0; pagina < n; pagina++) {
+      int inicio = pagina * self->quadro_tam;
+      int tam_pag = tam - inicio < self->quadro_tam ? tam - inicio : self->quadro_tam;
+      self->espalhamentos[prog][pagina] = so_espalha(PROGRS[prog] + inicio, tam_pag, self->quadro_tam);
+      self->zeradas[prog][pagina] = true;
+      for(int i = pagina * self->quadro_tam; i < tam && i < (pagina + 1) * self->quadro_tam; i++) {
+        if(PROGRS[prog][i] != 0) {
+          self->zeradas[prog][pagina] = false;
+          break;
+        }
+      }
+    }
+  }
 }
 
 /** Cria um processo e o inicializa com o programa desejado */
 static proc_t* so_cria_processo(so_t *self, int prog)
 {
-  if(prog > sizeof(PROGRS)/4-1 || prog < 0) {
-    t_printf("Programa inválido");
+  if(prog >= N_PROGRS || prog < 0) {
+    t_printf(self->tela, "Programa inválido");
     return NULL;
   }
 
@@ -396,12 +1315,42 @@ static proc_t* so_cria_processo(so_t *self, int prog)
   int* progr = PROGRS[prog];
   int tam_progr = PROGRS_SIZE[prog]/sizeof(progr[0]);
 
-  proc->quantum = MAX_QUANTUM;
-  proc->tempo_esperado = MAX_QUANTUM;
+  proc->quantum = self->max_quantum;
+  proc->tempo_esperado = self->max_quantum;
   proc->cpue = cpue_cria();
-  proc->mem = mem_cria(tam_progr);
-  proc->tab_pag = tab_pag_cria(tam_progr/QUADRO_TAM + 1, QUADRO_TAM);
+  // a memória do processo não é copiada: as páginas vêm da imagem do
+  //   programa na primeira falha
+  proc->imagem = progr;
+  proc->zeradas = self->zeradas[prog];
+  proc->espalhamentos = self->espalhamentos[prog];
+  proc->tam = tam_progr;
+  proc->n_paginas = (tam_progr + self->quadro_tam - 1) / self->quadro_tam;
+  proc->sec = calloc(proc->n_paginas, sizeof(int*));
   proc->id = self->processos.max_pid;
+  proc->quadros = -1;
+  proc->n_quadros = 0;
+  proc->privada = calloc(proc->n_paginas, sizeof(bool));
+  proc->comp = malloc(proc->n_paginas * sizeof(pag_compartilhada_t));
+  for(int p = 0; p < proc->n_paginas; p++) {
+    proc->comp[p].prox_usuario = NULL;
+    proc->comp[p].ant = proc->comp[p].prox = -1;
+  }
+  proc->compartilhadas = -1;
+  proc->pag_espera = -1;
+  proc->n_espera = 0;
+  proc->quadros_espera[0] = -1;
+  proc->fim_espera = 0;
+  proc->pc_falha = -1;
+  proc->n_presos = 0;
+  proc->ultima_falha = -1;
+  proc->n_residentes = 0;
+  proc->cota = self->n_quadros;
+  proc->demanda = self->config.demanda_min;
+  proc->falhas_janela = 0;
+  proc->tics_janela = 0;
+  int max_paginas = self->config.max_paginas;
+  if(max_paginas < proc->n_paginas) max_paginas = proc->n_paginas;
+  proc->tab_pag = tab_pag_cria(self->tab_pags, max_paginas, self->quadro_tam, proc->id);
   proc->prog = prog;
   cpue_muda_modo(proc->cpue, usuario);
   so_inicializa_metricas_proc(self, proc);
@@ -409,15 +1358,7 @@ static proc_t* so_cria_processo(so_t *self, int prog)
   proc_list_push_front(self->processos.prontos, proc);
   self->processos.max_pid++;
 
-  t_printf("Processo %d criado", proc->id);
-
-  for (int i = 0; i < tam_progr; i++) {
-    if (mem_escreve(proc->mem, i, progr[i]) != ERR_OK) {
-      t_printf("Falha na inicialização do processo %d", proc->id);
-      panico(self);
-      return proc;
-    }
-  }
+  t_printf(self->tela, "Processo %d criado", proc->id);
 
   return proc;
 }
@@ -428,15 +1369,19 @@ static void so_finaliza_processo(so_t *self, proc_t* proc)
   if(self->processos.atual == proc) {
     self->processos.atual = NULL;
   }
+  so_termina_instrucao(self, proc);
   int agora = rel_agora(self->rel);
   proc->metricas.tempo_total = agora - proc->metricas.hora_criacao;
   proc->metricas.tempo_cpu += agora - proc->metricas.hora_execucao;
 
   so_imprime_metricas_processo(self, proc);
-  for(int c=0; c<N_QUADROS; c++) {
-    if(proc == so_mem_quadro(self->so_mem, c).proc) {
-      so_mem_libera(self->so_mem, c);
-    }
+  // as páginas do processo que estão na memória: as dos quadros de que ele
+  //   é o dono, e as que estão em quadros compartilhados de outros
+  while(proc->quadros != -1) {
+    so_desmapeia(self, proc, so_mem_quadro(self->so_mem, proc->quadros).pagina, false);
+  }
+  while(proc->compartilhadas != -1) {
+    so_desmapeia(self, proc, proc->compartilhadas, false);
   }
 
   proc_destroi(proc);
@@ -558,8 +1503,8 @@ static proc_t* so_encontra_shortest(so_t *self) {
 }
 
 static void so_imprime_metricas_processo(so_t* self, proc_t* proc) {
-  char filename[64];
-  snprintf(filename, sizeof(filename), "%s%d%s", "./metricas/proc-", proc->id, ".txt");
+  char filename[CONFIG_NOME_TAM + 64];
+  snprintf(filename, sizeof(filename), "%s/proc-%d.txt", self->dir_metricas, proc->id);
   FILE* file = fopen(filename, "w");
   if(file == NULL) return;
 
@@ -574,12 +1519,34 @@ static void so_imprime_metricas_processo(so_t* self, proc_t* proc) {
   fprintf(file, "Número de bloqueios: ................................... %d\n", metricas.bloqueios);
   fprintf(file, "Número de preempções: .................................. %d\n", metricas.preempcoes);
   fprintf(file, "Número de falhas de página: ............................ %d\n", metricas.falhas_pagina);
+  fprintf(file, "Taxa de falhas de página (por 1000 unidades de CPU): ... %.1f\n", metricas.tempo_cpu > 0 ? metricas.falhas_pagina * 1000.0 / metricas.tempo_cpu : 0.0);
+  fprintf(file, "Número de suspensões: .................................. %d\n", metricas.suspensoes);
+  fprintf(file, "Páginas substituídas sem alteração: .................... %d\n", metricas.substituicoes_limpas);
+  fprintf(file, "Páginas substituídas com alteração: .................... %d\n", metricas.substituicoes_alteradas);
+  fprintf(file, "Páginas copiadas para o disco em segundo plano: ........ %d\n", metricas.limpezas_fundo);
+  fprintf(file, "Páginas trazidas antecipadamente e usadas: ............. %d\n", metricas.prebuscas_usadas);
+  fprintf(file, "Páginas trazidas antecipadamente e não usadas: ......... %d\n", metricas.prebuscas_perdidas);
+  fprintf(file, "Falhas resolvidas com quadro compartilhado: ............ %d\n", metricas.compartilhamentos);
+  fprintf(file, "Cópias de páginas compartilhadas (escrita): ............ %d\n", metricas.copias_escrita);
+  fprintf(file, "Falhas resolvidas com página zerada: ................... %d\n", metricas.paginas_zeradas);
+  fprintf(file, "Número de acertos na TLB: .............................. %d\n", metricas.tlb_acertos);
+  fprintf(file, "Número de falhas na TLB: ............................... %d\n", metricas.tlb_falhas);
+  fprintf(file, "Traduções da TLB mantidas entre execuções: ............. %d\n", metricas.tlb_salvas);
 
   fclose(file);
 }
 
+static char *nome_subst[] = {
+  [SUBST_GLOBAL] = "global",
+  [SUBST_LOCAL_IGUAL] = "local, cotas iguais",
+  [SUBST_LOCAL_PROPORCIONAL] = "local, cotas proporcionais ao programa",
+  [SUBST_LOCAL_PFF] = "local, cotas pela frequência de falhas",
+};
+
 static void so_imprime_metricas(so_t* self) {
-  FILE* file = fopen("./metricas/so.txt", "w");
+  char filename[CONFIG_NOME_TAM + 64];
+  snprintf(filename, sizeof(filename), "%s/so.txt", self->dir_metricas);
+  FILE* file = fopen(filename, "w");
   if(file == NULL) return;
 
   so_metricas_t metricas = self->metricas;
@@ -591,6 +1558,24 @@ static void so_imprime_metricas(so_t* self) {
   fprintf(file, "Número de interrupções recebidas: ............ %d\n", metricas.interrupcoes);
   fprintf(file, "Número de sisops recebidas: .................. %d\n", metricas.sisops);
   fprintf(file, "Número de falhas de página: .................. %d\n", metricas.falhas_pagina);
+  fprintf(file, "Substituição de páginas: ..................... %s\n", nome_subst[self->subst]);
+  fprintf(file, "Controle de carga: ........................... %s\n", self->config.controle_carga ? "sim" : "não");
+  fprintf(file, "Prebusca sequencial / pré-paginação: ......... %d / %s\n", self->config.prebusca_seq, self->config.pre_paginacao ? "sim" : "não");
+  fprintf(file, "Quadros da memória / tamanho: ................ %d / %d\n", self->n_quadros, self->quadro_tam);
+  fprintf(file, "Taxa de falhas (por 1000 unidades de CPU): ... %.1f\n", metricas.tempo_cpu > 0 ? metricas.falhas_pagina * 1000.0 / metricas.tempo_cpu : 0.0);
+  fprintf(file, "Número de suspensões: ........................ %d\n", metricas.suspensoes);
+  fprintf(file, "Páginas substituídas sem alteração: .......... %d\n", metricas.substituicoes_limpas);
+  fprintf(file, "Páginas substituídas com alteração: .......... %d\n", metricas.substituicoes_alteradas);
+  fprintf(file, "Páginas copiadas em segundo plano: ........... %d\n", metricas.limpezas_fundo);
+  fprintf(file, "Páginas antecipadas e usadas: ................ %d\n", metricas.prebuscas_usadas);
+  fprintf(file, "Páginas antecipadas e não usadas: ............ %d\n", metricas.prebuscas_perdidas);
+  fprintf(file, "Falhas com quadro compartilhado: ............. %d\n", metricas.compartilhamentos);
+  fprintf(file, "Cópias de páginas compartilhadas: ............ %d\n", metricas.copias_escrita);
+  fprintf(file, "Falhas com página zerada: .................... %d\n", metricas.paginas_zeradas);
+  fprintf(file, "Número de acertos na TLB: .................... %d\n", metricas.tlb_acertos);
+  fprintf(file, "Número de falhas na TLB: ..................... %d\n", metricas.tlb_falhas);
+  fprintf(file, "Traduções da TLB mantidas entre execuções: ... %d\n", metricas.tlb_salvas);
+  fprintf(file, "Memória das tabelas de páginas (bytes): ...... %ld\n", tab_pag_memoria_max(self->tab_pags));
 
   fclose(file);
 }
\ No newline at end of file
@@ -10,6 +10,7 @@
 
 
 typedef struct so_t so_t;
+typedef struct config_t config_t;
 
 // as chamadas de sistema
 typedef enum {
@@ -21,12 +22,37 @@ typedef enum {
 
 #include "contr.h"
 #include "err.h"
+#include "alg_pag.h"
 #include <stdbool.h>
 
-so_t *so_cria(contr_t *contr);
+// alcance da substituição de páginas
+typedef enum {
+  SUBST_GLOBAL,             // qualquer página pode ser substituída
+  SUBST_LOCAL_IGUAL,        // cada processo substitui suas páginas, com cotas
+                            //   iguais de quadros
+  SUBST_LOCAL_PROPORCIONAL, // cotas proporcionais ao tamanho do programa
+  SUBST_LOCAL_PFF,          // cotas proporcionais à demanda estimada pela
+                            //   frequência de falhas de página
+} so_subst_t;
+
+// escalonadores de processos
+typedef enum {
+  ROUND_ROBIN,
+  SHORTEST
+} escalonador_t;
+
+// cria o SO, com os parâmetros de 'config' (o escalonador, o quantum, a
+//   substituição de páginas, o tamanho dos quadros e o programa inicial)
+so_t *so_cria(contr_t *contr, config_t *config);
 
 void so_destroi(so_t *self);
 
+// muda o algoritmo de substituição de páginas
+void so_muda_alg_pag(so_t *self, alg_pag_tipo_t tipo);
+
+// muda o alcance da substituição de páginas (global ou local, com cotas)
+void so_muda_subst(so_t *self, so_subst_t subst);
+
 // houve uma interrupção do tipo err — trate-a
 void so_int(so_t *self, err_t err);
 
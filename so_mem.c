@@ -3,36 +3,183 @@
 #include <assert.h>
 #include <stdlib.h>
 
+// uma lista de quadros, encadeada pelos campos 'ant' e 'prox'
+typedef struct {
+  int inicio;
+  int fim;
+} lista_quadros_t;
+
 struct so_mem {
-  quadro_t quadros[N_QUADROS];    // Contém a informação acerca dos quadros da memória principal
+  quadro_t* quadros;              // Contém a informação acerca dos quadros da memória principal
+  int n_quadros;                  // Número de quadros da memória principal
+  lista_quadros_t livres;         // Quadros livres
+  lista_quadros_t ocupados;       // Quadros ocupados, do mais antigo ao mais novo
+  int n_livres;                   // Número de quadros na lista de livres
   int ultima_posicao;
+  int* baldes;                    // Primeiro quadro compartilhável de cada balde da tabela de espalhamento (-1 se nenhum)
+  int n_baldes;                   // Número de baldes (potência de 2)
 };
 
-so_mem_t* so_mem_cria() {
-    assert(MEM_TAM % QUADRO_TAM == 0);
+// insere o quadro no final da lista
+static void lista_insere(so_mem_t* self, lista_quadros_t* lista, int n_quadro) {
+    quadro_t* q = &self->quadros[n_quadro];
+    q->ant = lista->fim;
+    q->prox = -1;
+    if(lista->fim == -1) {
+        lista->inicio = n_quadro;
+    } else {
+        self->quadros[lista->fim].prox = n_quadro;
+    }
+    lista->fim = n_quadro;
+}
+
+// remove o quadro da lista
+static void lista_remove(so_mem_t* self, lista_quadros_t* lista, int n_quadro) {
+    quadro_t* q = &self->quadros[n_quadro];
+    if(q->ant == -1) {
+        lista->inicio = q->prox;
+    } else {
+        self->quadros[q->ant].prox = q->prox;
+    }
+    if(q->prox == -1) {
+        lista->fim = q->ant;
+    } else {
+        self->quadros[q->prox].ant = q->ant;
+    }
+    q->ant = q->prox = -1;
+}
+
+// insere o quadro na lista de quadros do processo
+static void proc_insere(so_mem_t* self, proc_t* proc, int n_quadro) {
+    quadro_t* q = &self->quadros[n_quadro];
+    q->ant_proc = -1;
+    q->prox_proc = proc->quadros;
+    if(proc->quadros != -1) {
+        self->quadros[proc->quadros].ant_proc = n_quadro;
+    }
+    proc->quadros = n_quadro;
+    proc->n_quadros++;
+}
+
+// remove o quadro da lista de quadros do processo
+static void proc_remove(so_mem_t* self, proc_t* proc, int n_quadro) {
+    quadro_t* q = &self->quadros[n_quadro];
+    if(q->ant_proc == -1) {
+        proc->quadros = q->prox_proc;
+    } else {
+        self->quadros[q->ant_proc].prox_proc = q->prox_proc;
+    }
+    if(q->prox_proc != -1) {
+        self->quadros[q->prox_proc].ant_proc = q->ant_proc;
+    }
+    q->ant_proc = q->prox_proc = -1;
+    proc->n_quadros--;
+}
+
+// insere a página na lista de páginas compartilhadas do processo
+static void comp_insere(proc_t* proc, int pagina) {
+    pag_compartilhada_t* c = &proc->comp[pagina];
+    c->ant = -1;
+    c->prox = proc->compartilhadas;
+    if(proc->compartilhadas != -1) {
+        proc->comp[proc->compartilhadas].ant = pagina;
+    }
+    proc->compartilhadas = pagina;
+}
+
+// remove a página da lista de páginas compartilhadas do processo
+static void comp_remove(proc_t* proc, int pagina) {
+    pag_compartilhada_t* c = &proc->comp[pagina];
+    if(c->ant == -1) {
+        proc->compartilhadas = c->prox;
+    } else {
+        proc->comp[c->ant].prox = c->prox;
+    }
+    if(c->prox != -1) {
+        proc->comp[c->prox].ant = c->ant;
+    }
+    c->ant = c->prox = -1;
+}
+
+// balde da tabela de espalhamento de uma página com esse conteúdo
+static int balde(so_mem_t* self, unsigned espalhamento, int pagina) {
+    return (espalhamento ^ (unsigned)pagina * 2654435761u) & (self->n_baldes - 1);
+}
+
+// insere o quadro compartilhável na tabela de espalhamento
+static void esp_insere(so_mem_t* self, int n_quadro) {
+    quadro_t* q = &self->quadros[n_quadro];
+    int* inicio = &self->baldes[balde(self, q->espalhamento, q->pagina)];
+    q->ant_esp = -1;
+    q->prox_esp = *inicio;
+    if(*inicio != -1) {
+        self->quadros[*inicio].ant_esp = n_quadro;
+    }
+    *inicio = n_quadro;
+}
+
+// remove o quadro da tabela de espalhamento, se estiver nela
+static void esp_remove(so_mem_t* self, int n_quadro) {
+    quadro_t* q = &self->quadros[n_quadro];
+    if(!q->compartilhavel) return;
+    if(q->ant_esp == -1) {
+        self->baldes[balde(self, q->espalhamento, q->pagina)] = q->prox_esp;
+    } else {
+        self->quadros[q->ant_esp].prox_esp = q->prox_esp;
+    }
+    if(q->prox_esp != -1) {
+        self->quadros[q->prox_esp].ant_esp = q->ant_esp;
+    }
+    q->ant_esp = q->prox_esp = -1;
+    q->compartilhavel = false;
+}
+
+so_mem_t* so_mem_cria(int n_quadros) {
+    assert(n_quadros > 0);
 
     so_mem_t* self = malloc(sizeof(so_mem_t));
+    self->quadros = malloc(n_quadros * sizeof(quadro_t));
+    self->n_quadros = n_quadros;
     self->ultima_posicao = 0;
-    for(int c=0; c<N_QUADROS; c++) {
+    self->livres.inicio = self->livres.fim = -1;
+    self->ocupados.inicio = self->ocupados.fim = -1;
+    self->n_livres = n_quadros;
+    self->n_baldes = 1;
+    while(self->n_baldes < n_quadros) self->n_baldes *= 2;
+    self->baldes = malloc(self->n_baldes * sizeof(int));
+    for(int b=0; b<self->n_baldes; b++) self->baldes[b] = -1;
+    for(int c=0; c<n_quadros; c++) {
         self->quadros[c].livre = true;
         self->quadros[c].proc = NULL;
         self->quadros[c].pagina = -1;
         self->quadros[c].posicao = -1;
+        self->quadros[c].presos = 0;
+        self->quadros[c].prebuscado = false;
+        self->quadros[c].compartilhavel = false;
+        self->quadros[c].refs = 0;
+        self->quadros[c].outros = NULL;
+        self->quadros[c].ant_proc = self->quadros[c].prox_proc = -1;
+        self->quadros[c].ant_esp = self->quadros[c].prox_esp = -1;
+        lista_insere(self, &self->livres, c);
     }
 
     return self;
 }
 
+int so_mem_num_quadros(so_mem_t* self) {
+    return self->n_quadros;
+}
+
 int so_mem_encontra_livre(so_mem_t* self) {
-    int index = -1;
-    for(int c=0; c<N_QUADROS; c++) {
-        if(self->quadros[c].livre) {
-            index = c;
-            break;
-        }
-    }
-    
-    return index;
+    return self->livres.inicio;
+}
+
+int so_mem_num_livres(so_mem_t* self) {
+    return self->n_livres;
+}
+
+int so_mem_mais_antigo(so_mem_t* self) {
+    return self->ocupados.inicio;
 }
 
 quadro_t so_mem_quadro(so_mem_t* self, int n_quadro) {
@@ -40,16 +187,106 @@ quadro_t so_mem_quadro(so_mem_t* self, int n_quadro) {
 }
 
 void so_mem_libera(so_mem_t* self, int n_quadro) {
-    self->quadros[n_quadro].livre = true;
+    quadro_t* q = &self->quadros[n_quadro];
+    if(q->livre) return;
+    esp_remove(self, n_quadro);
+    lista_remove(self, &self->ocupados, n_quadro);
+    proc_remove(self, q->proc, n_quadro);
+    lista_insere(self, &self->livres, n_quadro);
+    self->n_livres++;
+    q->livre = true;
+    q->presos = 0;
+    q->prebuscado = false;
+    q->refs = 0;
+    q->outros = NULL;
+}
+
+void so_mem_prende(so_mem_t* self, int n_quadro, bool preso) {
+    self->quadros[n_quadro].presos += preso ? 1 : -1;
+}
+
+void so_mem_marca_prebuscado(so_mem_t* self, int n_quadro, bool prebuscado) {
+    self->quadros[n_quadro].prebuscado = prebuscado;
+}
+
+void so_mem_compartilha(so_mem_t* self, int n_quadro, bool compartilhavel,
+                        unsigned espalhamento) {
+    quadro_t* q = &self->quadros[n_quadro];
+    esp_remove(self, n_quadro);
+    q->compartilhavel = compartilhavel;
+    q->espalhamento = espalhamento;
+    if(compartilhavel) esp_insere(self, n_quadro);
+}
+
+int so_mem_encontra_compartilhado(so_mem_t* self, unsigned espalhamento,
+                                  int pagina, int depois) {
+    int c = depois == -1 ? self->baldes[balde(self, espalhamento, pagina)]
+                         : self->quadros[depois].prox_esp;
+    for(; c != -1; c = self->quadros[c].prox_esp) {
+        quadro_t* q = &self->quadros[c];
+        if(q->compartilhavel && q->espalhamento == espalhamento
+           && q->pagina == pagina) return c;
+    }
+    return -1;
+}
+
+void so_mem_referencia(so_mem_t* self, int n_quadro, proc_t* proc) {
+    quadro_t* q = &self->quadros[n_quadro];
+    proc->comp[q->pagina].prox_usuario = q->outros;
+    q->outros = proc;
+    comp_insere(proc, q->pagina);
+    q->refs++;
+}
+
+void so_mem_desreferencia(so_mem_t* self, int n_quadro, proc_t* proc) {
+    quadro_t* q = &self->quadros[n_quadro];
+    if(proc == q->proc) {
+        // o primeiro dos outros passa a ser o dono
+        proc_t* dono = q->outros;
+        q->outros = dono->comp[q->pagina].prox_usuario;
+        comp_remove(dono, q->pagina);
+        proc_remove(self, q->proc, n_quadro);
+        proc_insere(self, dono, n_quadro);
+        q->proc = dono;
+    } else {
+        proc_t** ant = &q->outros;
+        while(*ant != proc) ant = &(*ant)->comp[q->pagina].prox_usuario;
+        *ant = proc->comp[q->pagina].prox_usuario;
+        comp_remove(proc, q->pagina);
+    }
+    q->refs--;
+}
+
+proc_t* so_mem_proximo_usuario(so_mem_t* self, int n_quadro, proc_t* proc) {
+    quadro_t* q = &self->quadros[n_quadro];
+    if(proc == NULL) return q->proc;
+    if(proc == q->proc) return q->outros;
+    return proc->comp[q->pagina].prox_usuario;
 }
 
 void so_mem_ocupa(so_mem_t* self, int n_quadro, proc_t* proc, int pagina) {
-    self->quadros[n_quadro].livre = false;
-    self->quadros[n_quadro].proc = proc;
-    self->quadros[n_quadro].pagina = pagina;
-    self->ultima_posicao++;
+    quadro_t* q = &self->quadros[n_quadro];
+    if(q->livre) {
+        lista_remove(self, &self->livres, n_quadro);
+        self->n_livres--;
+    } else {
+        esp_remove(self, n_quadro);
+        lista_remove(self, &self->ocupados, n_quadro);
+        proc_remove(self, q->proc, n_quadro);
+    }
+    lista_insere(self, &self->ocupados, n_quadro);
+    proc_insere(self, proc, n_quadro);
+    q->livre = false;
+    q->proc = proc;
+    q->pagina = pagina;
+    q->prebuscado = false;
+    q->refs = 1;
+    q->outros = NULL;
+    q->posicao = ++self->ultima_posicao;
 }
 
 void so_mem_destroi(so_mem_t* self) {
+    free(self->baldes);
+    free(self->quadros);
     free(self);
-}
\ No newline at end of file
+}
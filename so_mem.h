@@ -5,35 +5,104 @@
 #include "contr.h"
 #include "proc.h"
 
+// Os quadros ficam sempre em uma de duas listas duplamente encadeadas
+// (pelos índices 'ant' e 'prox'): a lista de quadros livres ou a fila
+// dos quadros ocupados, em ordem de carga (o mais antigo no início).
+// Os quadros ocupados ficam também na lista de quadros do processo dono
+// (começa em proc->quadros, encadeada por 'ant_proc' e 'prox_proc').
+// Assim, alocar, liberar ou ocupar um quadro não precisa percorrer a
+// tabela de quadros.
+// Um quadro com uma página ainda não alterada da imagem de um programa
+// pode ser usado por vários processos cuja página de mesmo número tem o
+// mesmo conteúdo (do mesmo programa ou não); ele fica na lista de um deles
+// (o dono), e conta quantos processos o usam; os outros ficam em uma lista
+// do quadro (começa em 'outros', encadeada por proc->comp[pagina]), e a
+// página de cada um deles fica na lista de páginas compartilhadas do
+// processo (começa em proc->compartilhadas, também encadeada por
+// proc->comp).
+// Os quadros que podem ser compartilhados ficam também em uma tabela de
+// espalhamento, pelo espalhamento do conteúdo e pelo número da página
+// (encadeados por 'ant_esp' e 'prox_esp'), para serem encontrados sem
+// percorrer os quadros ocupados.
+
 typedef struct {
   bool livre;                     // Informa se o quadro está livre
   proc_t* proc;                   // Qual o último processo que usou o quadro
   int pagina;                     // A qual página do processo o quadro corresponde
-  int posicao;                    // Qual a posição do quadro em relação aos outros (usado no FIFO)
+  int posicao;                    // Qual a posição do quadro em relação aos outros (ordem de carga)
+  int presos;                     // Quantas vezes o quadro está preso (não pode ser substituído: página em transferência ou usada pela instrução que falhou)
+  bool prebuscado;                // A página foi trazida antecipadamente e ainda não foi acessada
+  bool compartilhavel;            // A página é igual à da imagem do programa, pode ser compartilhada
+  unsigned espalhamento;          // Espalhamento do conteúdo da página (se compartilhável)
+  int refs;                       // Número de processos que usam o quadro (o dono e os que compartilham)
+  proc_t* outros;                 // Primeiro dos processos que compartilham o quadro, além do dono (NULL se nenhum)
+  int ant, prox;                  // Vizinhos na lista de livres ou na fila de carga (-1 se nenhum)
+  int ant_proc, prox_proc;        // Vizinhos na lista de quadros do processo (-1 se nenhum)
+  int ant_esp, prox_esp;          // Vizinhos na lista da tabela de espalhamento (-1 se nenhum)
 } quadro_t;
 
-#define MEM_TAM 300 // tamanho da memória principal
-#define QUADRO_TAM 50
-#define N_QUADROS (MEM_TAM/QUADRO_TAM)
-
 typedef struct so_mem so_mem_t;
 
-// aloca um descritor
-so_mem_t* so_mem_cria();
+// aloca um descritor, para uma memória com 'n_quadros' quadros
+so_mem_t* so_mem_cria(int n_quadros);
+
+// retorna o número de quadros da memória
+int so_mem_num_quadros(so_mem_t* self);
 
 // retorna o índice de um quadro livre (-1 caso nenhum)
 int so_mem_encontra_livre(so_mem_t* self);
 
+// retorna o número de quadros livres
+int so_mem_num_livres(so_mem_t* self);
+
+// retorna o índice do quadro ocupado há mais tempo (-1 caso nenhum)
+int so_mem_mais_antigo(so_mem_t* self);
+
 // marca um quadro como livre
 void so_mem_libera(so_mem_t* self, int n_quadro);
 
-// marca um quadro como ocupado
+// marca um quadro como ocupado pela página 'pagina' do processo 'proc'
+// se o quadro estava ocupado por outra página, ela perde o quadro
 void so_mem_ocupa(so_mem_t* so_mem, int n_quadro, proc_t* proc, int pagina);
 
+// prende (ou solta) um quadro ocupado: um quadro preso não pode ser
+// escolhido para substituição; o quadro pode ser preso mais de uma vez
+// (por processos que o compartilham), e fica preso até ser solto tantas
+// vezes quanto foi preso
+void so_mem_prende(so_mem_t* self, int n_quadro, bool preso);
+
+// marca (ou desmarca) o quadro como contendo uma página trazida
+// antecipadamente, ainda não acessada; ocupar o quadro desmarca
+void so_mem_marca_prebuscado(so_mem_t* self, int n_quadro, bool prebuscado);
+
+// marca o quadro como contendo uma página igual à da imagem do programa,
+// cujo conteúdo tem o espalhamento 'espalhamento', que pode ser
+// compartilhada com outros processos ('compartilhavel' false se a página é
+// privada do processo); ocupar o quadro torna privada
+void so_mem_compartilha(so_mem_t* self, int n_quadro, bool compartilhavel,
+                        unsigned espalhamento);
+
+// retorna o próximo quadro depois de 'depois' (-1 para o primeiro) com a
+// página 'pagina' que pode ser compartilhada e cujo conteúdo tem o
+// espalhamento 'espalhamento' (-1 caso nenhum); quem vai compartilhar o
+// quadro deve conferir se o conteúdo é mesmo igual
+int so_mem_encontra_compartilhado(so_mem_t* self, unsigned espalhamento,
+                                  int pagina, int depois);
+
+// o processo 'proc' passa a usar (ou deixa de usar) o quadro compartilhado;
+// ocupar o quadro conta um, o dono; se o dono deixa de usar o quadro, um
+// dos outros passa a ser o dono (o quadro passa para a lista dele)
+void so_mem_referencia(so_mem_t* self, int n_quadro, proc_t* proc);
+void so_mem_desreferencia(so_mem_t* self, int n_quadro, proc_t* proc);
+
+// retorna o processo que usa o quadro depois de 'proc' (o dono se 'proc'
+// for NULL), ou NULL se não houver mais nenhum
+proc_t* so_mem_proximo_usuario(so_mem_t* self, int n_quadro, proc_t* proc);
+
 // retorna informações sobre o quadro
 quadro_t so_mem_quadro(so_mem_t* self, int n_quadro);
 
 // desaloca um descritor
 void so_mem_destroi(so_mem_t* self);
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,55 @@
+#include <stdlib.h>
+#include "swap.h"
+
+struct swap_t {
+    rel_t* rel;
+    int tempo_acesso;   // tempo fixo de cada pedido
+    int tempo_transf;   // tempo de transferência de cada página
+    int fim;            // hora em que termina o último pedido
+};
+
+swap_t *swap_cria(rel_t *rel, int tempo_acesso, int tempo_transf)
+{
+    swap_t* self = malloc(sizeof(swap_t));
+    if(self == NULL) return NULL;
+    self->rel = rel;
+    self->tempo_acesso = tempo_acesso;
+    self->tempo_transf = tempo_transf;
+    self->fim = 0;
+
+    return self;
+}
+
+void swap_destroi(swap_t *self)
+{
+    free(self);
+}
+
+err_t swap_le(void *disp, int id, int *pvalor)
+{
+    if(id != 0) return ERR_OP_INV;
+
+    swap_t* self = (swap_t*)disp;
+    *pvalor = self->fim;
+
+    return ERR_OK;
+}
+
+err_t swap_escr(void *disp, int id, int valor)
+{
+    if(id != 0 || valor < 0) return ERR_OP_INV;
+
+    swap_t* self = (swap_t*)disp;
+    // o pedido começa quando o anterior terminar
+    int inicio = rel_agora(self->rel);
+    if(self->fim > inicio) inicio = self->fim;
+    self->fim = inicio + self->tempo_acesso + valor * self->tempo_transf;
+
+    return ERR_OK;
+}
+
+bool swap_pronto(void *disp, int id, acesso_t acesso)
+{
+    swap_t* self = (swap_t*)disp;
+    return rel_agora(self->rel) >= self->fim;
+}
@@ -0,0 +1,37 @@
+#ifndef SWAP_H
+#define SWAP_H
+
+#include <stdbool.h>
+#include "es.h"
+#include "err.h"
+#include "rel.h"
+
+// Dispositivo de armazenamento secundário usado na paginação (disco de
+// swap)
+// Não transfere os dados (o SO copia as páginas), só simula o tempo das
+// transferências: cada pedido de 'n' páginas ocupa o dispositivo durante
+// 'tempo_acesso' + n * 'tempo_transf' unidades de tempo, e os pedidos são
+// atendidos em ordem
+typedef struct swap_t swap_t;
+
+// número do dispositivo no controlador de E/S
+#define SWAP_DISP 11
+
+// cria e inicializa o dispositivo
+// retorna NULL em caso de erro
+swap_t *swap_cria(rel_t *rel, int tempo_acesso, int tempo_transf);
+
+// destrói o dispositivo
+// nenhuma outra operação pode ser realizada no dispositivo após esta chamada
+void swap_destroi(swap_t *self);
+
+// Funções para implementar o protocolo de acesso a um dispositivo pelo
+//   controlador de E/S
+// escrever o valor n pede a transferência de n páginas
+// ler retorna a hora em que termina a última transferência pedida
+// está pronto quando não tem transferência em andamento
+err_t swap_le(void *disp, int id, int *pvalor);
+err_t swap_escr(void *disp, int id, int valor);
+bool swap_pronto(void *disp, int id, acesso_t acesso);
+
+#endif // SWAP_H
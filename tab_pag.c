@@ -2,32 +2,95 @@
 #include <stdlib.h>
 #include <stdbool.h>
 
+// a tabela tem dois níveis: um diretório, com um ponteiro para cada grupo
+//   de FOLHA_TAM páginas, e as folhas, com os descritores das páginas de um
+//   grupo; uma folha só é alocada quando uma das suas páginas recebe
+//   informação, então um espaço de endereçamento grande e esparso (código
+//   no início, pilha no fim) só ocupa as folhas das regiões usadas
+// uma página de uma folha que não existe é inválida
+// a MMU guarda as folhas que percorreu (tab_pag_folha), e traduz as
+//   páginas de uma folha que já conhece sem passar pelo diretório
+#define FOLHA_BITS 5
+#define FOLHA_TAM (1 << FOLHA_BITS)  // páginas em uma folha
+
 typedef struct {
   bool valida;    // esta entrada é válida
   int quadro;     // em que quadro está esta página
   bool acessada;  // esta página foi acessada
   bool alterada;  // esta página foi alterada
+  bool protegida; // esta página não pode ser escrita
 } descr_pag_t;
 
+struct tab_pag_folha_t {
+  descr_pag_t descr[FOLHA_TAM];
+};
+
+// o conjunto só mede a memória usada pelas tabelas (agora e no máximo)
+struct tab_pag_conj_t {
+  long bytes;
+  long bytes_max;
+};
+
 struct tab_pag_t {
+  tab_pag_conj_t *conj;
   int num_pag;
   int tam_pag;
-  descr_pag_t *tab;
+  int bits_pag;             // log2 de tam_pag (-1 se não for potência de 2)
+  int asid;
+  int num_dir;              // número de entradas do diretório
+  tab_pag_folha_t **dir;    // as folhas (NULL se ainda não alocada)
+  tab_pag_f_muda_t f_muda;  // função chamada quando uma página muda
+  void *arg_muda;           // argumento para f_muda
 };
 
-tab_pag_t *tab_pag_cria(int num_pag, int tam_pag)
+static void conta_bytes(tab_pag_t *self, long n)
+{
+  tab_pag_conj_t *conj = self->conj;
+  conj->bytes += n;
+  if (conj->bytes > conj->bytes_max) conj->bytes_max = conj->bytes;
+}
+
+tab_pag_conj_t *tab_pag_conj_cria(int n_quadros)
+{
+  // as tabelas de cada processo não dependem do tamanho da memória
+  // calloc zera a memória, nenhum byte usado
+  return calloc(1, sizeof(tab_pag_conj_t));
+}
+
+void tab_pag_conj_destroi(tab_pag_conj_t *self)
+{
+  free(self);
+}
+
+long tab_pag_memoria_max(tab_pag_conj_t *self)
+{
+  return self->bytes_max;
+}
+
+tab_pag_t *tab_pag_cria(tab_pag_conj_t *conj, int num_pag, int tam_pag,
+                        int asid)
 {
   tab_pag_t *self;
   self = malloc(sizeof(*self));
   if (self != NULL) {
+    self->conj = conj;
     self->num_pag = num_pag;
     self->tam_pag = tam_pag;
-    // calloc zera a memória, os descritores terão 'false' em 'valida'
-    self->tab = calloc(num_pag, sizeof(descr_pag_t));
-    if (self->tab == NULL) {
+    self->bits_pag = -1;
+    if ((tam_pag & (tam_pag - 1)) == 0) {
+      self->bits_pag = __builtin_ctz(tam_pag);
+    }
+    self->asid = asid;
+    self->f_muda = NULL;
+    self->arg_muda = NULL;
+    self->num_dir = (num_pag + FOLHA_TAM - 1) / FOLHA_TAM;
+    // calloc zera a memória, nenhuma folha existe
+    self->dir = calloc(self->num_dir, sizeof(tab_pag_folha_t *));
+    if (self->dir == NULL) {
       free(self);
       return NULL;
     }
+    conta_bytes(self, sizeof(*self) + self->num_dir * sizeof(tab_pag_folha_t *));
   }
   return self;
 }
@@ -35,16 +98,65 @@ tab_pag_t *tab_pag_cria(int num_pag, int tam_pag)
 void tab_pag_destroi(tab_pag_t *self)
 {
   if (self != NULL) {
-    free(self->tab);
+    if (self->f_muda != NULL) {
+      self->f_muda(self->arg_muda, self, -1);
+    }
+    for (int d = 0; d < self->num_dir; d++) {
+      if (self->dir[d] != NULL) {
+        free(self->dir[d]);
+        conta_bytes(self, -(long)sizeof(tab_pag_folha_t));
+      }
+    }
+    conta_bytes(self, -(long)(sizeof(*self) + self->num_dir * sizeof(tab_pag_folha_t *)));
+    free(self->dir);
     free(self);
   }
 }
 
+// função auxiliar, retorna o descritor da página 'pag', NULL se a página
+//   está fora da tabela ou a sua folha não existe; se 'cria', a folha é
+//   alocada se necessário
+static inline descr_pag_t *descr(tab_pag_t *self, int pag, bool cria)
+{
+  if (pag < 0 || pag >= self->num_pag) {
+    return NULL;
+  }
+  tab_pag_folha_t **pfolha = &self->dir[pag >> FOLHA_BITS];
+  if (*pfolha == NULL) {
+    if (!cria) return NULL;
+    // calloc zera a memória, os descritores terão 'false' em 'valida'
+    *pfolha = calloc(1, sizeof(tab_pag_folha_t));
+    if (*pfolha == NULL) return NULL;
+    conta_bytes(self, sizeof(tab_pag_folha_t));
+  }
+  return &(*pfolha)->descr[pag & (FOLHA_TAM - 1)];
+}
+
+void tab_pag_observa(tab_pag_t *self, tab_pag_f_muda_t f, void *arg)
+{
+  self->f_muda = f;
+  self->arg_muda = arg;
+}
+
+// função auxiliar, avisa que a página mudou
+static void avisa_muda(tab_pag_t *self, int pag)
+{
+  if (self->f_muda != NULL) {
+    self->f_muda(self->arg_muda, self, pag);
+  }
+}
+
 err_t tab_pag_traduz(tab_pag_t *self, int end_v,
                      int *pend_f, int *ppag, int *pdesl, int *pquadro)
 {
-  int pagina = end_v / self->tam_pag;
-  int deslocamento = end_v % self->tam_pag;
+  int pagina, deslocamento;
+  if (self->bits_pag >= 0 && end_v >= 0) {
+    pagina = end_v >> self->bits_pag;
+    deslocamento = end_v & (self->tam_pag - 1);
+  } else {
+    pagina = end_v / self->tam_pag;
+    deslocamento = end_v % self->tam_pag;
+  }
   if (ppag != NULL) {
     *ppag = pagina;
   }
@@ -54,10 +166,11 @@ err_t tab_pag_traduz(tab_pag_t *self, int end_v,
   if (pagina < 0 || pagina >= self->num_pag) {
     return ERR_PAGINV;
   }
-  if (!self->tab[pagina].valida) {
+  descr_pag_t *dp = descr(self, pagina, false);
+  if (dp == NULL || !dp->valida) {
     return ERR_FALPAG;
   }
-  int quadro = self->tab[pagina].quadro;
+  int quadro = dp->quadro;
   if (pquadro != NULL) {
     *pquadro = quadro;
   }
@@ -67,51 +180,128 @@ err_t tab_pag_traduz(tab_pag_t *self, int end_v,
   return ERR_OK;
 }
 
+int tab_pag_bits_folha(tab_pag_t *self)
+{
+  return FOLHA_BITS;
+}
+
+tab_pag_folha_t *tab_pag_folha(tab_pag_t *self, int pag)
+{
+  if (pag < 0 || pag >= self->num_pag) {
+    return NULL;
+  }
+  return self->dir[pag >> FOLHA_BITS];
+}
+
+err_t tab_pag_acessa(tab_pag_t *self, tab_pag_folha_t *folha, int pag,
+                     bool escrita, int *pquadro, bool *pprotegida)
+{
+  // a última folha pode ter páginas depois do fim da tabela
+  if (pag >= self->num_pag) {
+    return ERR_PAGINV;
+  }
+  descr_pag_t *dp = &folha->descr[pag & (FOLHA_TAM - 1)];
+  if (!dp->valida || (escrita && dp->protegida)) {
+    return ERR_FALPAG;
+  }
+  dp->acessada = true;
+  if (escrita) {
+    dp->alterada = true;
+  }
+  *pquadro = dp->quadro;
+  *pprotegida = dp->protegida;
+  return ERR_OK;
+}
+
+int tab_pag_asid(tab_pag_t *self)
+{
+  return self->asid;
+}
+
+int tab_pag_tam_pag(tab_pag_t *self)
+{
+  return self->tam_pag;
+}
+
+int tab_pag_bits_pag(tab_pag_t *self)
+{
+  return self->bits_pag;
+}
+
 bool tab_pag_valida(tab_pag_t *self, int pag)
 {
-  return self->tab[pag].valida;
+  descr_pag_t *dp = descr(self, pag, false);
+  return dp != NULL && dp->valida;
 }
 
 
 int tab_pag_quadro(tab_pag_t *self, int pag)
 {
-  return self->tab[pag].quadro;
+  descr_pag_t *dp = descr(self, pag, false);
+  return dp == NULL ? -1 : dp->quadro;
 }
 
 
 bool tab_pag_acessada(tab_pag_t *self, int pag)
 {
-  return self->tab[pag].acessada;
+  descr_pag_t *dp = descr(self, pag, false);
+  return dp != NULL && dp->acessada;
 }
 
 
 bool tab_pag_alterada(tab_pag_t *self, int pag)
 {
-  return self->tab[pag].alterada;
+  descr_pag_t *dp = descr(self, pag, false);
+  return dp != NULL && dp->alterada;
+}
+
+
+bool tab_pag_protegida(tab_pag_t *self, int pag)
+{
+  descr_pag_t *dp = descr(self, pag, false);
+  return dp != NULL && dp->protegida;
 }
 
 
 
 // altera informação sobre uma página da tabela
+// (a folha só é alocada quando a página recebe um valor diferente do
+//   inicial)
 void tab_pag_muda_valida(tab_pag_t *self, int pag, bool val)
 {
-  self->tab[pag].valida = val;
+  descr_pag_t *dp = descr(self, pag, val);
+  if (dp != NULL) dp->valida = val;
+  avisa_muda(self, pag);
 }
 
 
 void tab_pag_muda_quadro(tab_pag_t *self, int pag, int val)
 {
-  self->tab[pag].quadro = val;
+  descr_pag_t *dp = descr(self, pag, true);
+  if (dp != NULL) dp->quadro = val;
+  avisa_muda(self, pag);
 }
 
 
 void tab_pag_muda_acessada(tab_pag_t *self, int pag, bool val)
 {
-  self->tab[pag].acessada = val;
+  descr_pag_t *dp = descr(self, pag, val);
+  if (dp != NULL) dp->acessada = val;
+  if (!val) avisa_muda(self, pag);
 }
 
 
 void tab_pag_muda_alterada(tab_pag_t *self, int pag, bool val)
 {
-  self->tab[pag].alterada = val;
+  descr_pag_t *dp = descr(self, pag, val);
+  if (dp != NULL) dp->alterada = val;
+  if (!val) avisa_muda(self, pag);
+}
+
+
+void tab_pag_muda_protegida(tab_pag_t *self, int pag, bool val)
+{
+  descr_pag_t *dp = descr(self, pag, val);
+  if (dp != NULL) dp->protegida = val;
+  avisa_muda(self, pag);
 }
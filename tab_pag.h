@@ -4,6 +4,10 @@
 // simulador de tabela de páginas
 // contém uma tabela com informação para a tradução de um endereço
 //   virtual em físico
+// há duas implementações desta interface: tab_pag.c, com uma tabela de
+//   dois níveis para cada processo, e tab_pag_inv.c, com uma tabela invertida
+//   única para todos os processos, do tamanho da memória física (o Makefile
+//   escolhe uma delas)
 
 #include "err.h"
 #include <stdbool.h>
@@ -11,15 +15,51 @@
 // tipo opaco que representa a tabela de páginas
 typedef struct tab_pag_t tab_pag_t;
 
-// cria uma tabela de páginas com suporte a 'num_pag' páginas
+// tipo opaco que representa o conjunto das tabelas de páginas de um SO (de
+//   todos os seus processos), que mede a memória ocupada por elas e, na
+//   tabela invertida, contém a própria tabela; os conjuntos são
+//   independentes, SOs diferentes podem executar ao mesmo tempo
+typedef struct tab_pag_conj_t tab_pag_conj_t;
+
+// cria um conjunto de tabelas, sem nenhuma tabela, para uma memória com
+//   'n_quadros' quadros (a tabela invertida é criada desse tamanho)
+// retorna NULL em caso de erro
+tab_pag_conj_t *tab_pag_conj_cria(int n_quadros);
+
+// destrói o conjunto, cujas tabelas já devem ter sido destruídas
+void tab_pag_conj_destroi(tab_pag_conj_t *self);
+
+// retorna o maior número de bytes ocupados ao mesmo tempo pelas tabelas de
+//   páginas do conjunto
+long tab_pag_memoria_max(tab_pag_conj_t *self);
+
+// cria uma tabela de páginas do conjunto 'conj' com suporte a 'num_pag' páginas
 //   de tamanho 'tam_pag' cada
+// só as páginas que recebem informação ocupam memória na tabela, então
+//   'num_pag' pode ser o tamanho máximo do espaço de endereçamento, mesmo
+//   que ele seja usado de forma esparsa
+// 'asid' identifica o espaço de endereçamento da tabela (deve ser diferente
+//   para cada tabela existente no conjunto), e é usado pela MMU para distinguir as
+//   traduções de tabelas diferentes
 // retorna NULL em caso de erro
-tab_pag_t *tab_pag_cria(int num_pag, int tam_pag);
+tab_pag_t *tab_pag_cria(tab_pag_conj_t *conj, int num_pag, int tam_pag,
+                        int asid);
 
 // destrói um tabela de páginas
 // nenhuma outra operação pode ser realizada na tabela após esta chamada
 void tab_pag_destroi(tab_pag_t *self);
 
+// função chamada quando a informação de uma página muda de forma que
+//   invalida uma tradução guardada fora da tabela (por exemplo em uma TLB):
+//   quando muda a validade, o quadro ou a proteção da página, ou quando o
+//   bit de acesso ou de alteração é desligado
+// 'pag' é -1 quando todas as páginas mudam (a tabela vai ser destruída)
+typedef void (*tab_pag_f_muda_t)(void *arg, tab_pag_t *tab_pag, int pag);
+
+// registra a função 'f' para ser chamada com 'arg' quando uma página da
+//   tabela mudar (só uma função é registrada, substitui a anterior)
+void tab_pag_observa(tab_pag_t *self, tab_pag_f_muda_t f, void *arg);
+
 // traduz o endereço virtual 'end_v' em endereço físico
 // coloca o resultado da tradução em '*pend_f' e retorna ERR_OK, ou,
 //   caso a tradução não seja possível, retorna:
@@ -27,18 +67,56 @@ void tab_pag_destroi(tab_pag_t *self);
 //   ERR_PAGINV a tabela não contém a página
 // se não forem NULL, coloca a página em *ppag, o deslocamento em *pdesl,
 //   e se a tradução foi OK, o quadro em *pquadro
+// a proteção contra escrita não é verificada (a tradução não depende do
+//   tipo de acesso), quem faz o acesso deve verificar
 err_t tab_pag_traduz(tab_pag_t *self, int end_v,
                      int *pend_f, int *ppag, int *pdesl, int *pquadro);
 
+// percurso da tabela pela MMU: as páginas são agrupadas em folhas, e a MMU
+//   guarda as folhas que encontrou (cache do percurso) para traduzir as
+//   páginas delas sem passar pelo diretório da tabela
+// tipo opaco que representa uma folha da tabela
+typedef struct tab_pag_folha_t tab_pag_folha_t;
+
+// retorna o log2 do número de páginas de uma folha (a página 'pag' está
+//   na folha número pag >> tab_pag_bits_folha())
+int tab_pag_bits_folha(tab_pag_t *self);
+
+// retorna a folha da página 'pag', ou NULL se a página está fora da tabela
+//   ou a folha não existe (a página é inválida)
+// a folha continua existindo até a tabela ser destruída
+tab_pag_folha_t *tab_pag_folha(tab_pag_t *self, int pag);
+
+// faz o acesso da MMU à página 'pag', que está em 'folha': coloca o quadro
+//   em '*pquadro' e se a página é protegida em '*pprotegida', e marca a
+//   página como acessada e, se 'escrita', como alterada
+// retorna ERR_FALPAG (sem marcar a página) se a página é inválida ou se é
+//   uma escrita em página protegida, ERR_PAGINV se está fora da tabela
+err_t tab_pag_acessa(tab_pag_t *self, tab_pag_folha_t *folha, int pag,
+                     bool escrita, int *pquadro, bool *pprotegida);
+
+// retorna o identificador do espaço de endereçamento da tabela
+int tab_pag_asid(tab_pag_t *self);
+
+// retorna o tamanho das páginas da tabela
+int tab_pag_tam_pag(tab_pag_t *self);
+
+// retorna o log2 do tamanho das páginas, se for uma potência de 2 (a página
+//   de um endereço é calculada com um deslocamento, sem divisão), senão -1
+int tab_pag_bits_pag(tab_pag_t *self);
+
 // obtém informação sobre uma página da tabela
 bool tab_pag_valida(tab_pag_t *self, int pag);
 int tab_pag_quadro(tab_pag_t *self, int pag);
 bool tab_pag_acessada(tab_pag_t *self, int pag);
 bool tab_pag_alterada(tab_pag_t *self, int pag);
+// uma escrita em uma página protegida deve causar falha de página
+bool tab_pag_protegida(tab_pag_t *self, int pag);
 
 // altera informação sobre uma página da tabela
 void tab_pag_muda_valida(tab_pag_t *self, int pag, bool val);
 void tab_pag_muda_quadro(tab_pag_t *self, int pag, int val);
 void tab_pag_muda_acessada(tab_pag_t *self, int pag, bool val);
 void tab_pag_muda_alterada(tab_pag_t *self, int pag, bool val);
+void tab_pag_muda_protegida(tab_pag_t *self, int pag, bool val);
 #endif  // TAB_PAG_H
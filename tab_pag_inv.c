@@ -0,0 +1,421 @@
+#include "tab_pag.h"
+#include <stdlib.h>
+#include <stdbool.h>
+
+// tabela de páginas invertida: implementa a mesma interface que tab_pag.c
+//   (o Makefile escolhe qual das duas é usada)
+// em vez de um descritor para cada página de cada processo, há uma só
+//   tabela, com uma entrada para cada página que está na memória principal
+//   (de qualquer processo), encontrada por espalhamento pelo par (asid,
+//   página); uma página sem entrada é inválida
+// a tabela começa com uma entrada para cada quadro da memória (arredondado
+//   para potência de 2)
+// a entrada de uma página que fica inválida mantém os bits até ser
+//   reaproveitada; a tabela só cresce quando todas as entradas são de
+//   páginas válidas (um quadro compartilhado tem uma entrada para cada
+//   processo), então o tamanho acompanha o número de quadros, não o
+//   tamanho dos processos
+
+typedef struct {
+  int asid;       // espaço de endereçamento da página (-1 se a entrada está livre)
+  int pagina;     // a página
+  bool valida;    // esta entrada é válida
+  int quadro;     // em que quadro está esta página
+  bool acessada;  // esta página foi acessada
+  bool alterada;  // esta página foi alterada
+  bool protegida; // esta página não pode ser escrita
+  int prox;       // próxima entrada da lista (de espalhamento ou de livres)
+} ent_inv_t;
+
+// o conjunto das tabelas é a tabela invertida, de todos os processos
+struct tab_pag_conj_t {
+  int tam_inicial; // número de entradas sem processos (potência de 2)
+  int tam;         // número de entradas (potência de 2)
+  int n_validas;   // entradas de páginas válidas
+  int n_tabelas;   // tabelas de páginas existentes
+  int reuso;       // próxima entrada examinada para ser reaproveitada
+  int livres;      // primeira entrada livre (-1 se nenhuma)
+  ent_inv_t *ent;
+  int *listas;     // primeira entrada de cada lista de espalhamento (2*tam)
+  long bytes;      // memória usada pelas tabelas
+  long bytes_max;  // maior valor de 'bytes'
+};
+
+// a tabela invertida não tem diretório: todas as páginas de um processo
+//   estão em uma só folha, que é a própria tabela do processo
+struct tab_pag_folha_t {
+  tab_pag_t *tab;
+};
+
+// cada processo tem só a identificação do seu espaço de endereçamento
+struct tab_pag_t {
+  tab_pag_conj_t *conj;
+  tab_pag_folha_t folha;    // a única folha, com todas as páginas
+  int num_pag;
+  int tam_pag;
+  int bits_pag;             // log2 de tam_pag (-1 se não for potência de 2)
+  int asid;
+  tab_pag_f_muda_t f_muda;  // função chamada quando uma página muda
+  void *arg_muda;           // argumento para f_muda
+};
+
+static void conta_bytes(tab_pag_conj_t *inv)
+{
+  inv->bytes = inv->n_tabelas * (long)sizeof(tab_pag_t)
+               + inv->tam * (long)(sizeof(ent_inv_t) + 2 * sizeof(int));
+  if (inv->bytes > inv->bytes_max) inv->bytes_max = inv->bytes;
+}
+
+static inline int espalha(tab_pag_conj_t *inv, int asid, int pagina)
+{
+  unsigned h = ((unsigned)asid * 0x9e3779b1u) ^ ((unsigned)pagina * 0x85ebca6bu);
+  return (h ^ (h >> 15)) & (2 * inv->tam - 1);
+}
+
+// coloca a entrada 'e' na lista de espalhamento da sua página
+static void liga(tab_pag_conj_t *inv, int e)
+{
+  int l = espalha(inv, inv->ent[e].asid, inv->ent[e].pagina);
+  inv->ent[e].prox = inv->listas[l];
+  inv->listas[l] = e;
+}
+
+// tira a entrada 'e' da lista de espalhamento da sua página
+static void desliga(tab_pag_conj_t *inv, int e)
+{
+  int *p = &inv->listas[espalha(inv, inv->ent[e].asid, inv->ent[e].pagina)];
+  while (*p != e) {
+    p = &inv->ent[*p].prox;
+  }
+  *p = inv->ent[e].prox;
+}
+
+// libera a entrada 'e' (que está em uma lista de espalhamento)
+static void libera(tab_pag_conj_t *inv, int e)
+{
+  desliga(inv, e);
+  if (inv->ent[e].valida) inv->n_validas--;
+  inv->ent[e].asid = -1;
+  inv->ent[e].prox = inv->livres;
+  inv->livres = e;
+}
+
+// aloca a tabela com 'tam' entradas, recolocando as entradas usadas
+static void redimensiona(tab_pag_conj_t *inv, int tam)
+{
+  ent_inv_t *velha = inv->ent;
+  int tam_velho = inv->tam;
+  inv->tam = tam;
+  inv->ent = malloc(tam * sizeof(ent_inv_t));
+  free(inv->listas);
+  inv->listas = malloc(2 * tam * sizeof(int));
+  for (int l = 0; l < 2 * tam; l++) {
+    inv->listas[l] = -1;
+  }
+  for (int e = 0; e < tam_velho; e++) {
+    inv->ent[e] = velha[e];
+    if (inv->ent[e].asid != -1) liga(inv, e);
+  }
+  inv->livres = -1;
+  for (int e = tam - 1; e >= tam_velho; e--) {
+    inv->ent[e].asid = -1;
+    inv->ent[e].prox = inv->livres;
+    inv->livres = e;
+  }
+  free(velha);
+  conta_bytes(inv);
+}
+
+// retorna a entrada da página, -1 se ela não tiver entrada
+static inline int busca(tab_pag_conj_t *inv, int asid, int pagina)
+{
+  int e = inv->listas[espalha(inv, asid, pagina)];
+  while (e != -1 && (inv->ent[e].asid != asid || inv->ent[e].pagina != pagina)) {
+    e = inv->ent[e].prox;
+  }
+  return e;
+}
+
+// retorna a entrada da página, criando uma (de página inválida) se não
+//   houver: usa uma livre, senão reaproveita a de uma página inválida,
+//   senão aumenta a tabela
+static int entrada(tab_pag_t *self, int pag)
+{
+  tab_pag_conj_t *inv = self->conj;
+  int e = busca(inv, self->asid, pag);
+  if (e != -1) return e;
+  if (inv->livres == -1) {
+    if (inv->n_validas < inv->tam) {
+      while (inv->ent[inv->reuso].valida) {
+        inv->reuso = (inv->reuso + 1) % inv->tam;
+      }
+      libera(inv, inv->reuso);
+    } else {
+      redimensiona(inv, inv->tam * 2);
+    }
+  }
+  e = inv->livres;
+  inv->livres = inv->ent[e].prox;
+  ent_inv_t *ent = &inv->ent[e];
+  ent->asid = self->asid;
+  ent->pagina = pag;
+  ent->valida = false;
+  ent->quadro = -1;
+  ent->acessada = false;
+  ent->alterada = false;
+  ent->protegida = false;
+  liga(inv, e);
+  return e;
+}
+
+tab_pag_conj_t *tab_pag_conj_cria(int n_quadros)
+{
+  // calloc zera a memória, nenhuma entrada usada
+  tab_pag_conj_t *self = calloc(1, sizeof(tab_pag_conj_t));
+  if (self == NULL) return NULL;
+  self->tam_inicial = 1;
+  while (self->tam_inicial < n_quadros) {
+    self->tam_inicial *= 2;
+  }
+  redimensiona(self, self->tam_inicial);
+  return self;
+}
+
+void tab_pag_conj_destroi(tab_pag_conj_t *self)
+{
+  free(self->ent);
+  free(self->listas);
+  free(self);
+}
+
+long tab_pag_memoria_max(tab_pag_conj_t *self)
+{
+  return self->bytes_max;
+}
+
+tab_pag_t *tab_pag_cria(tab_pag_conj_t *conj, int num_pag, int tam_pag,
+                        int asid)
+{
+  tab_pag_t *self;
+  self = malloc(sizeof(*self));
+  if (self != NULL) {
+    tab_pag_conj_t *inv = conj;
+    self->conj = conj;
+    self->folha.tab = self;
+    self->num_pag = num_pag;
+    self->tam_pag = tam_pag;
+    self->bits_pag = -1;
+    if ((tam_pag & (tam_pag - 1)) == 0) {
+      self->bits_pag = __builtin_ctz(tam_pag);
+    }
+    self->asid = asid;
+    self->f_muda = NULL;
+    self->arg_muda = NULL;
+    inv->n_tabelas++;
+    conta_bytes(inv);
+  }
+  return self;
+}
+
+void tab_pag_destroi(tab_pag_t *self)
+{
+  if (self != NULL) {
+    tab_pag_conj_t *inv = self->conj;
+    if (self->f_muda != NULL) {
+      self->f_muda(self->arg_muda, self, -1);
+    }
+    for (int e = 0; e < inv->tam; e++) {
+      if (inv->ent[e].asid == self->asid) libera(inv, e);
+    }
+    free(self);
+    if (--inv->n_tabelas == 0 && inv->tam > inv->tam_inicial) {
+      // sem processos, a tabela volta ao tamanho inicial
+      free(inv->ent);
+      inv->ent = NULL;
+      inv->tam = inv->n_validas = inv->reuso = 0;
+      redimensiona(inv, inv->tam_inicial);
+    }
+    conta_bytes(inv);
+  }
+}
+
+void tab_pag_observa(tab_pag_t *self, tab_pag_f_muda_t f, void *arg)
+{
+  self->f_muda = f;
+  self->arg_muda = arg;
+}
+
+// função auxiliar, avisa que a página mudou
+static void avisa_muda(tab_pag_t *self, int pag)
+{
+  if (self->f_muda != NULL) {
+    self->f_muda(self->arg_muda, self, pag);
+  }
+}
+
+err_t tab_pag_traduz(tab_pag_t *self, int end_v,
+                     int *pend_f, int *ppag, int *pdesl, int *pquadro)
+{
+  int pagina, deslocamento;
+  if (self->bits_pag >= 0 && end_v >= 0) {
+    pagina = end_v >> self->bits_pag;
+    deslocamento = end_v & (self->tam_pag - 1);
+  } else {
+    pagina = end_v / self->tam_pag;
+    deslocamento = end_v % self->tam_pag;
+  }
+  if (ppag != NULL) {
+    *ppag = pagina;
+  }
+  if (pdesl != NULL) {
+    *pdesl = deslocamento;
+  }
+  if (pagina < 0 || pagina >= self->num_pag) {
+    return ERR_PAGINV;
+  }
+  int e = busca(self->conj, self->asid, pagina);
+  if (e == -1 || !self->conj->ent[e].valida) {
+    return ERR_FALPAG;
+  }
+  int quadro = self->conj->ent[e].quadro;
+  if (pquadro != NULL) {
+    *pquadro = quadro;
+  }
+  if (pend_f != NULL) {
+    *pend_f = quadro * self->tam_pag + deslocamento;
+  }
+  return ERR_OK;
+}
+
+int tab_pag_bits_folha(tab_pag_t *self)
+{
+  // nenhuma página (que não é negativa) tem esse bit, estão todas na folha 0
+  return 31;
+}
+
+tab_pag_folha_t *tab_pag_folha(tab_pag_t *self, int pag)
+{
+  if (pag < 0 || pag >= self->num_pag) {
+    return NULL;
+  }
+  return &self->folha;
+}
+
+err_t tab_pag_acessa(tab_pag_t *self, tab_pag_folha_t *folha, int pag,
+                     bool escrita, int *pquadro, bool *pprotegida)
+{
+  if (pag >= self->num_pag) {
+    return ERR_PAGINV;
+  }
+  int e = busca(self->conj, self->asid, pag);
+  if (e == -1) {
+    return ERR_FALPAG;
+  }
+  ent_inv_t *ent = &self->conj->ent[e];
+  if (!ent->valida || (escrita && ent->protegida)) {
+    return ERR_FALPAG;
+  }
+  ent->acessada = true;
+  if (escrita) {
+    ent->alterada = true;
+  }
+  *pquadro = ent->quadro;
+  *pprotegida = ent->protegida;
+  return ERR_OK;
+}
+
+int tab_pag_asid(tab_pag_t *self)
+{
+  return self->asid;
+}
+
+int tab_pag_tam_pag(tab_pag_t *self)
+{
+  return self->tam_pag;
+}
+
+int tab_pag_bits_pag(tab_pag_t *self)
+{
+  return self->bits_pag;
+}
+
+bool tab_pag_valida(tab_pag_t *self, int pag)
+{
+  int e = busca(self->conj, self->asid, pag);
+  return e != -1 && self->conj->ent[e].valida;
+}
+
+
+int tab_pag_quadro(tab_pag_t *self, int pag)
+{
+  int e = busca(self->conj, self->asid, pag);
+  return e == -1 ? -1 : self->conj->ent[e].quadro;
+}
+
+
+bool tab_pag_acessada(tab_pag_t *self, int pag)
+{
+  int e = busca(self->conj, self->asid, pag);
+  return e != -1 && self->conj->ent[e].acessada;
+}
+
+
+bool tab_pag_alterada(tab_pag_t *self, int pag)
+{
+  int e = busca(self->conj, self->asid, pag);
+  return e != -1 && self->conj->ent[e].alterada;
+}
+
+
+bool tab_pag_protegida(tab_pag_t *self, int pag)
+{
+  int e = busca(self->conj, self->asid, pag);
+  return e != -1 && self->conj->ent[e].protegida;
+}
+
+
+
+// altera informação sobre uma página da tabela
+// (uma página inválida só ganha entrada se for alterada para outro valor)
+void tab_pag_muda_valida(tab_pag_t *self, int pag, bool val)
+{
+  int e = val ? entrada(self, pag) : busca(self->conj, self->asid, pag);
+  if (e != -1 && self->conj->ent[e].valida != val) {
+    self->conj->ent[e].valida = val;
+    self->conj->n_validas += val ? 1 : -1;
+  }
+  avisa_muda(self, pag);
+}
+
+
+void tab_pag_muda_quadro(tab_pag_t *self, int pag, int val)
+{
+  // entrada() pode realocar a tabela, 'ent' só é lido depois
+  int e = entrada(self, pag);
+  self->conj->ent[e].quadro = val;
+  avisa_muda(self, pag);
+}
+
+
+void tab_pag_muda_acessada(tab_pag_t *self, int pag, bool val)
+{
+  int e = val ? entrada(self, pag) : busca(self->conj, self->asid, pag);
+  if (e != -1) self->conj->ent[e].acessada = val;
+  if (!val) avisa_muda(self, pag);
+}
+
+
+void tab_pag_muda_alterada(tab_pag_t *self, int pag, bool val)
+{
+  int e = val ? entrada(self, pag) : busca(self->conj, self->asid, pag);
+  if (e != -1) self->conj->ent[e].alterada = val;
+  if (!val) avisa_muda(self, pag);
+}
+
+
+void tab_pag_muda_protegida(tab_pag_t *self, int pag, bool val)
+{
+  int e = val ? entrada(self, pag) : busca(self->conj, self->asid, pag);
+  if (e != -1) self->conj->ent[e].protegida = val;
+  avisa_muda(self, pag);
+}
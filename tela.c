@@ -1,10 +1,20 @@
 #include "tela.h"
 
+#include <stdlib.h>
 #include <string.h>
 #include <curses.h>  // tomara que eu não me arrependa!
 #include <locale.h>
 #include <stdarg.h>
 #include <ctype.h>
+#include <pthread.h>
+#include <time.h>
+
+// a tela é desenhada por uma thread própria, QUADROS_POR_SEGUNDO vezes por
+//   segundo, a partir de uma cópia do estado; só as linhas que mudaram
+//   desde o último quadro são redesenhadas
+// a simulação só altera o estado (protegido por 'mutex'), nunca chama o
+//   curses e nunca espera por ele
+#define QUADROS_POR_SEGUNDO 30
 
 // fila de números
 #define FN_TAM 9  // quantos números cabem numa fila
@@ -54,116 +64,173 @@ typedef enum {
   executa_direto,
 } modo_da_console_t;
 
-struct {
+struct tela_t {
   fila_de_numeros entrada[N_TERM];        // uma fila de entrada por terminal
   fila_de_numeros saida[N_TERM];          // uma fila de saída por terminal
   char txt_status[N_COL+1];               // texto da linha de status
+  bool quer_status;                       // txt_status já foi mostrado
   char txt_console[N_LIN_CONS][N_COL+1];  // texto das linhas da console
   char digitando[N_COL+1];                // texto da linha sendo digitada
   modo_da_console_t modo;                 // modo de operação
-} tela;
+  bool fim;                               // a simulação terminou
+  // protege o resto, que é alterado pela simulação e pela thread que desenha
+  pthread_mutex_t mutex;
+  // sinalizada quando o modo muda (para sair da pausa)
+  pthread_cond_t muda_modo;
+  // a thread que desenha a tela
+  pthread_t desenhista;
+};
+
+// uma linha da tela, como foi (ou vai ser) desenhada
+typedef struct {
+  char txt[N_COL+3];
+  int cor;        // par de cores da linha
+  bool destaque;  // o último número da linha está destacado (fila cheia)
+} linha_t;
 
-void t_inicio(void)
+static void *desenha_tela(void *arg);
+
+tela_t *t_inicio(char *console)
 {
-  // inicializa a tela
+  // inicializa a tela (a console é mostrada nela, 'console' não é usado)
+  tela_t *self = calloc(1, sizeof(*self));
+  if (self == NULL) return NULL;
+  pthread_mutex_init(&self->mutex, NULL);
+  pthread_cond_init(&self->muda_modo, NULL);
   for (int t=0; t<N_TERM; t++) {
-    fn_zera(&tela.entrada[t]);
-    fn_zera(&tela.saida[t]);
+    fn_zera(&self->entrada[t]);
+    fn_zera(&self->saida[t]);
   }
   for (int l=0; l<N_LIN_CONS; l++) {
-    tela.txt_console[l][0] = '\0';
+    self->txt_console[l][0] = '\0';
   }
-  tela.digitando[0] = '\0';
+  self->digitando[0] = '\0';
+  self->txt_status[0] = '\0';
+  self->quer_status = true;
+  self->fim = false;
 
   // inicializa o curses
   setlocale(LC_ALL, "");  // para ter suporte a UTF8
   initscr();
   cbreak();      // lê cada char, não espera enter
   noecho();      // não mostra o que é digitado
-  timeout(10);  // não espera digitar, retorna ERR se nada foi digitado
+  timeout(0);    // não espera digitar, retorna ERR se nada foi digitado
   start_color();
   init_pair(1, COLOR_GREEN, COLOR_BLACK);
   init_pair(2, COLOR_YELLOW, COLOR_BLACK);
   init_pair(3, COLOR_BLUE, COLOR_BLACK);
   init_pair(4, COLOR_GREEN, COLOR_BLACK);
   init_pair(5, COLOR_BLACK, COLOR_RED);
+
+  // a partir daqui, só a thread desenhista usa o curses
+  pthread_create(&self->desenhista, NULL, desenha_tela, self);
+  return self;
 }
 
-void t_fim(void)
+void t_fim(tela_t *self)
 {
-  t_atualiza();
-  attron(COLOR_PAIR(5));
-  addstr("  digite ENTER para sair  ");
-  while (getch() != '\n') {
-    ;
-  }
+  // a thread desenhista desenha o último quadro, espera o ENTER e termina
+  pthread_mutex_lock(&self->mutex);
+  self->fim = true;
+  pthread_mutex_unlock(&self->mutex);
+  pthread_join(self->desenhista, NULL);
   // acaba com o curses
   endwin();
+  pthread_cond_destroy(&self->muda_modo);
+  pthread_mutex_destroy(&self->mutex);
+  free(self);
 }
 
-bool t_livre(int t)
+bool t_livre(tela_t *self, int t)
 {
-  return !fn_cheia(&tela.saida[t]);
+  pthread_mutex_lock(&self->mutex);
+  bool livre = !fn_cheia(&self->saida[t]);
+  pthread_mutex_unlock(&self->mutex);
+  return livre;
 }
 
-void t_print(int t, int n)
+void t_print(tela_t *self, int t, int n)
 {
-  fn_ins(&tela.saida[t], n);
+  pthread_mutex_lock(&self->mutex);
+  fn_ins(&self->saida[t], n);
+  pthread_mutex_unlock(&self->mutex);
 }
 
-bool t_tem(int t)
+bool t_tem(tela_t *self, int t)
 {
-  return !fn_vazia(&tela.entrada[t]);
+  pthread_mutex_lock(&self->mutex);
+  bool tem = !fn_vazia(&self->entrada[t]);
+  pthread_mutex_unlock(&self->mutex);
+  return tem;
 }
 
-int t_le(int t)
+int t_le(tela_t *self, int t)
 {
-  return fn_rem(&tela.entrada[t]);
+  pthread_mutex_lock(&self->mutex);
+  int n = fn_rem(&self->entrada[t]);
+  pthread_mutex_unlock(&self->mutex);
+  return n;
 }
 
-void t_ins(int t, int n)
+void t_ins(tela_t *self, int t, int n)
 {
-  fn_ins(&tela.entrada[t], n);
+  pthread_mutex_lock(&self->mutex);
+  fn_ins(&self->entrada[t], n);
+  pthread_mutex_unlock(&self->mutex);
 }
 
-static void insere_string_na_console(char *s)
+static void insere_string_na_console(tela_t *self, char *s)
 {
   for(int l=0; l<N_LIN_CONS-1; l++) {
-    strncpy(tela.txt_console[l], tela.txt_console[l+1], N_COL);
-    tela.txt_console[l][N_COL] = '\0'; // quem definiu strncpy é estúpido!
+    strncpy(self->txt_console[l], self->txt_console[l+1], N_COL);
+    self->txt_console[l][N_COL] = '\0'; // quem definiu strncpy é estúpido!
   }
-  strncpy(tela.txt_console[N_LIN_CONS-1], s, N_COL);
-  tela.txt_console[N_LIN_CONS-1][N_COL] = '\0'; // grrrr
+  strncpy(self->txt_console[N_LIN_CONS-1], s, N_COL);
+  self->txt_console[N_LIN_CONS-1][N_COL] = '\0'; // grrrr
 }
 
-static void insere_strings_na_console(char *s)
+static void insere_strings_na_console(tela_t *self, char *s)
 {
   while (*s != '\0') {
     char *f = strchr(s, '\n');
     if (f != NULL) {
       *f = '\0';
     }
-    insere_string_na_console(s);
+    insere_string_na_console(self, s);
     if (f == NULL) break;
     s = f+1;
   }
 }
 
-void t_status(char *txt)
+void t_status(tela_t *self, char *txt)
 {
+  pthread_mutex_lock(&self->mutex);
   // imprime alinhado a esquerda ("-"), max N_COL chars ("*")
-  sprintf(tela.txt_status, "%-*s", N_COL, txt);
+  snprintf(self->txt_status, sizeof(self->txt_status), "%-*s", N_COL, txt);
+  self->quer_status = false;
+  pthread_mutex_unlock(&self->mutex);
 }
 
-int t_printf(char *formato, ...)
+bool t_quer_status(tela_t *self)
+{
+  pthread_mutex_lock(&self->mutex);
+  bool quer = self->quer_status || self->modo != executa_direto;
+  pthread_mutex_unlock(&self->mutex);
+  return quer;
+}
+
+int t_printf(tela_t *self, char *formato, ...)
 {
   // esta função usa número variável de argumentos. Dá uma olhada em:
   // https://www.geeksforgeeks.org/variadic-functions-in-c/
-  char s[sizeof(tela.txt_console)];
+  char s[sizeof(self->txt_console)];
   va_list arg;
   va_start(arg, formato);
   int r = vsnprintf(s, sizeof(s), formato, arg);
-  insere_strings_na_console(s);
+  va_end(arg);
+  pthread_mutex_lock(&self->mutex);
+  insere_strings_na_console(self, s);
+  pthread_mutex_unlock(&self->mutex);
   return r;
 }
 
@@ -175,7 +242,8 @@ static int term(char c)
   return -1;
 }
 
-static void interpreta_entrada(void)
+// chamada pela thread desenhista, com o mutex travado
+static void interpreta_entrada(tela_t *self)
 {
   // Comandos aceitos (mudou em relação a t0c!):
   // etn entra o número n no terminal t  ex: eb30
@@ -186,132 +254,195 @@ static void interpreta_entrada(void)
   // c   continua a execução
   char *err = "OK";
   int t, n;
-  switch (tolower(tela.digitando[0])) {
+  switch (tolower(self->digitando[0])) {
     case 'e':
-      if ((t = term(tela.digitando[1])) == -1) {
+      if ((t = term(self->digitando[1])) == -1) {
         err = "terminal inválido";
-      } else if (sscanf(tela.digitando+2, "%d", &n) != 1) {
+      } else if (sscanf(self->digitando+2, "%d", &n) != 1) {
         err = "esperava número";
-      } else if (fn_cheia(&tela.entrada[t])) {
+      } else if (fn_cheia(&self->entrada[t])) {
         err = "fila cheia";
       } else {
-        fn_ins(&tela.entrada[t], n);
+        fn_ins(&self->entrada[t], n);
       }
       break;
     case 'l':
-      if ((t = term(tela.digitando[1])) == -1) {
+      if ((t = term(self->digitando[1])) == -1) {
         err = "terminal inválido";
-      } else if (fn_vazia(&tela.saida[t])) {
+      } else if (fn_vazia(&self->saida[t])) {
         err = "fila vazia";
       } else {
-        fn_rem(&tela.saida[t]);
+        fn_rem(&self->saida[t]);
       }
       break;
     case 'z':
-      if ((t = term(tela.digitando[1])) == -1) {
+      if ((t = term(self->digitando[1])) == -1) {
         err = "terminal inválido";
       } else {
-        fn_zera(&tela.saida[t]);
+        fn_zera(&self->saida[t]);
       }
       break;
     case 'p':
-      tela.modo = nao_sai_da_console;
+      self->modo = nao_sai_da_console;
       break;
     case 's':
-      tela.modo = deixa_executar_1;
+      self->modo = deixa_executar_1;
+      pthread_cond_signal(&self->muda_modo);
       break;
     case 'c':
-      tela.modo = executa_direto;
+      self->modo = executa_direto;
+      pthread_cond_signal(&self->muda_modo);
       break;
     default:
       err = "não reconhecido";
   }
-  t_printf("%s [%s]", tela.digitando, err);
-  tela.digitando[0] = '\0';
+  char s[N_COL*2];
+  snprintf(s, sizeof(s), "%s [%s]", self->digitando, err);
+  insere_strings_na_console(self, s);
+  self->digitando[0] = '\0';
 }
 
 // vê se tem algum caractere digitado no teclado
 //   adiciona à linha sendo digitada ou remove se for backspace ou
 //   interpreta a linha se for enter
-static void verifica_entrada(void)
+// chamada pela thread desenhista, com o mutex travado
+static void verifica_entrada(tela_t *self)
 {
-  int ch = getch();
-  if (ch == ERR) return;
-  int l = strlen(tela.digitando);
-  if ((ch == '\b' || ch == 0x7f)) {   // backspace ou del
-    if (l > 0) {
-      tela.digitando[l-1] = '\0';
-    }
-  } else if (ch == '\n') {
-    interpreta_entrada();
-  } else if (ch >= ' ' && ch < 127 && l < N_COL) {
-    tela.digitando[l] = ch;
-    tela.digitando[l+1] = '\0';
-  } // senão, ignora o caractere digitado
+  int ch;
+  while ((ch = getch()) != ERR) {
+    int l = strlen(self->digitando);
+    if ((ch == '\b' || ch == 0x7f)) {   // backspace ou del
+      if (l > 0) {
+        self->digitando[l-1] = '\0';
+      }
+    } else if (ch == '\n') {
+      interpreta_entrada(self);
+    } else if (ch >= ' ' && ch < 127 && l < N_COL) {
+      self->digitando[l] = ch;
+      self->digitando[l+1] = '\0';
+    } // senão, ignora o caractere digitado
+  }
 }
 
-static void desenha_terminal(int t)
+// monta o texto das linhas da tela a partir do estado atual
+// chamada pela thread desenhista, com o mutex travado
+static void monta_linhas(tela_t *self, linha_t linhas[N_LIN])
 {
-  mvprintw(t*2, 0, "S%c%*s", t+'a', N_COL, "");
-  mvprintw(t*2+1, 0, "E%c%*s", t+'a', N_COL, "");
-  for (int i=0; i<fn_n(&tela.saida[t]); i++) {
-    if (i == FN_TAM-1) attron(COLOR_PAIR(5));
-    mvprintw(t*2, i*8+2, "%8d", fn_num(&tela.saida[t], i));
-    if (i == FN_TAM-1) attroff(COLOR_PAIR(5));
+  for (int t=0; t<N_TERM; t++) {
+    linha_t *s = &linhas[t*2];
+    linha_t *e = &linhas[t*2+1];
+    int n = 0;
+    n += sprintf(s->txt, "S%c", t+'a');
+    for (int i=0; i<fn_n(&self->saida[t]); i++) {
+      n += sprintf(s->txt+n, "%8d", fn_num(&self->saida[t], i));
+    }
+    sprintf(s->txt+n, "%*s", N_COL-n+2, "");
+    s->cor = 1+t%2;
+    s->destaque = fn_cheia(&self->saida[t]);
+    n = sprintf(e->txt, "E%c", t+'a');
+    for (int i=0; i<fn_n(&self->entrada[t]); i++) {
+      n += sprintf(e->txt+n, "%8d", fn_num(&self->entrada[t], i));
+    }
+    sprintf(e->txt+n, "%*s", N_COL-n+2, "");
+    e->cor = 1+t%2;
+    e->destaque = false;
   }
-  for (int i=0; i<fn_n(&tela.entrada[t]); i++) {
-    mvprintw(t*2+1, i*8+2, "%8d", fn_num(&tela.entrada[t], i));
+  linha_t *st = &linhas[N_TERM*2];
+  snprintf(st->txt, sizeof(st->txt), "%-*s", N_COL, self->txt_status);
+  st->cor = 4;
+  st->destaque = false;
+  for (int l=0; l<N_LIN_CONS; l++) {
+    linha_t *c = &linhas[N_LIN - 1 - N_LIN_CONS + l];
+    snprintf(c->txt, sizeof(c->txt), "%-*s", N_COL, self->txt_console[l]);
+    c->cor = 3;
+    c->destaque = false;
   }
+  linha_t *en = &linhas[N_LIN-1];
+  snprintf(en->txt, sizeof(en->txt), "%*s", N_COL,
+           "P=para C=continua S=passo Lt=lê Zt=zera Etn=entra");
+  memcpy(en->txt, self->digitando, strlen(self->digitando));
+  en->cor = 4;
+  en->destaque = false;
 }
 
-static void desenha_terminais(void)
+// desenha as linhas que mudaram em relação a 'antigas', e atualiza 'antigas'
+static void desenha_linhas(linha_t novas[N_LIN], linha_t antigas[N_LIN])
 {
-  for (int t=0; t<N_TERM; t++) {
-    attron(COLOR_PAIR(1+t%2));
-    desenha_terminal(t);
-    attroff(COLOR_PAIR(1+t%2));
+  for (int y=0; y<N_LIN; y++) {
+    linha_t *nova = &novas[y];
+    linha_t *antiga = &antigas[y];
+    if (nova->cor == antiga->cor && nova->destaque == antiga->destaque
+        && strcmp(nova->txt, antiga->txt) == 0) {
+      continue;
+    }
+    attron(COLOR_PAIR(nova->cor));
+    mvaddstr(y, 0, nova->txt);
+    attroff(COLOR_PAIR(nova->cor));
+    if (nova->destaque) {
+      int x = (FN_TAM-1)*8+2;
+      attron(COLOR_PAIR(5));
+      mvaddnstr(y, x, nova->txt+x, 8);
+      attroff(COLOR_PAIR(5));
+    }
+    *antiga = *nova;
   }
 }
 
-static void desenha_status(void)
+// espera até a hora do próximo quadro
+static void espera_quadro(void)
 {
-  attron(COLOR_PAIR(4));
-  mvprintw(N_TERM*2, 0, "%-*s", N_COL, tela.txt_status);
-  attroff(COLOR_PAIR(4));
+  struct timespec t = { 0, 1000000000 / QUADROS_POR_SEGUNDO };
+  nanosleep(&t, NULL);
 }
 
-static void desenha_console(void)
+// a thread desenhista: lê o teclado e desenha a tela periodicamente, até
+//   a simulação terminar; então desenha o último quadro e espera ENTER
+static void *desenha_tela(void *arg)
 {
-  attron(COLOR_PAIR(3));
-  for (int l=0; l<N_LIN_CONS; l++) {
-    int y = N_LIN - 1 - N_LIN_CONS + l;
-    mvprintw(y, 0, "%-*s", N_COL, tela.txt_console[l]);
+  tela_t *self = arg;
+  linha_t novas[N_LIN], antigas[N_LIN];
+  // força o desenho de todas as linhas no primeiro quadro
+  for (int y=0; y<N_LIN; y++) antigas[y].cor = -1;
+  bool fim;
+  do {
+    pthread_mutex_lock(&self->mutex);
+    verifica_entrada(self);
+    monta_linhas(self, novas);
+    self->quer_status = true;
+    fim = self->fim;
+    pthread_mutex_unlock(&self->mutex);
+
+    desenha_linhas(novas, antigas);
+    refresh();
+    if (!fim) espera_quadro();
+  } while (!fim);
+
+  attron(COLOR_PAIR(5));
+  addstr("  digite ENTER para sair  ");
+  refresh();
+  timeout(-1);
+  while (getch() != '\n') {
+    ;
   }
-  attroff(COLOR_PAIR(3));
+  return NULL;
 }
 
-static void desenha_entrada(void)
+bool t_passo_a_passo(tela_t *self)
 {
-  attron(COLOR_PAIR(4));
-  mvprintw(N_LIN-1, 0, "%*s", N_COL, 
-           "P=para C=continua S=passo Lt=lê Zt=zera Etn=entra");
-  mvprintw(N_LIN-1, 0, "%s", tela.digitando);
-  attroff(COLOR_PAIR(4));
+  pthread_mutex_lock(&self->mutex);
+  bool passo = self->modo != executa_direto;
+  pthread_mutex_unlock(&self->mutex);
+  return passo;
 }
 
-void t_atualiza(void)
+void t_atualiza(tela_t *self)
 {
-  if (tela.modo == deixa_executar_1) tela.modo = nao_sai_da_console;
-  do {
-    verifica_entrada();
-
-    // desenha a tela
-    desenha_terminais();
-    desenha_status();
-    desenha_console();
-    desenha_entrada();
-
-    // manda o curses fazer aparecer tudo isso
-    refresh();
-  } while (tela.modo == nao_sai_da_console);
-}
\ No newline at end of file
+  // a tela é desenhada pela outra thread; aqui só espera se a execução
+  //   estiver parada (até o usuário pedir para executar)
+  pthread_mutex_lock(&self->mutex);
+  if (self->modo == deixa_executar_1) self->modo = nao_sai_da_console;
+  while (self->modo == nao_sai_da_console && !self->fim) {
+    pthread_cond_wait(&self->muda_modo, &self->mutex);
+  }
+  pthread_mutex_unlock(&self->mutex);
+}
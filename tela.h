@@ -16,36 +16,51 @@
 #define N_COL 80  // número de colunas na tela
 #define N_TERM 8  // número de terminais, cada um ocupa 2 linhas na tela
 
+typedef struct tela_t tela_t;
+
 // inicializa a tela
-void t_inicio(void);
+// a tela sem interface escreve a console no arquivo 'console' quando é
+//   finalizada (na saída padrão, se for NULL); a outra mostra a console e
+//   ignora 'console'
+tela_t *t_inicio(char *console);
 
 // finaliza a utilização da tela
-void t_fim(void);
+// nenhuma outra operação pode ser realizada na tela após esta chamada
+void t_fim(tela_t *self);
 
 // retorna true se o terminal t estiver livre (para ser escrito)
-bool t_livre(int t);
+bool t_livre(tela_t *self, int t);
 
 // escreve o número n no terminal t
 // só deve ser chamada quando o terminal tiver livre
-void t_print(int t, int n);
+void t_print(tela_t *self, int t, int n);
 
 // retorna true se tiver número pronto para ser lido no terminal t
-bool t_tem(int t);
+bool t_tem(tela_t *self, int t);
 
 // lê um número do terminal t
 // só deve ser chamada quando tiver número pronto no terminal t
-int t_le(int t);
+int t_le(tela_t *self, int t);
 
 // insere um número a ser lido do terminal t
-void t_ins(int t, int n);
+void t_ins(tela_t *self, int t, int n);
 
 // imprime na linha de status
-void t_status(char *txt);
+void t_status(tela_t *self, char *txt);
+
+// retorna true se a linha de status vai ser mostrada (se o último texto
+//   passado a t_status já foi mostrado ou ainda não tem texto)
+// serve para evitar montar o texto do status quando ninguém vai vê-lo
+bool t_quer_status(tela_t *self);
 
 // imprime no console
-int t_printf(char *formato, ...);
+int t_printf(tela_t *self, char *formato, ...);
+
+// retorna true se a execução está sendo feita passo a passo (ou está parada)
+//   nesse caso só deve ser executada uma instrução a cada t_atualiza
+bool t_passo_a_passo(tela_t *self);
 
 // esta função deve ser chamada periodicamente para que tela funcione
-void t_atualiza(void);
+void t_atualiza(tela_t *self);
 
 #endif // _TELA_H_
\ No newline at end of file
@@ -0,0 +1,144 @@
+#include "tela.h"
+
+// implementação da tela sem interface (headless)
+// mantém os terminais e a console em memória, sem desenhar nada, para
+//   que a simulação rode na velocidade do simulador e termine sozinha
+// ao final, imprime a console na saída padrão
+// a saída dos terminais nunca fica cheia: quando não há mais espaço, o
+//   número mais antigo é descartado
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+
+#define FN_TAM 9  // quantos números cabem numa fila
+typedef struct {
+  int num[FN_TAM]; // os números
+  int n;           // quantos números válidos tem
+} fila_de_numeros;
+
+static void fn_ins(fila_de_numeros *f, int n) // insere n, descarta o primeiro se cheia
+{
+  if (f->n >= FN_TAM) {
+    memmove(&(f->num[0]), &(f->num[1]), (FN_TAM-1) * sizeof(int));
+    f->n--;
+  }
+  f->num[f->n++] = n;
+}
+static int fn_rem(fila_de_numeros *f)  // remove (e retorna) o próximo da fila
+{
+  if (f->n <= 0) return 0;
+  int r = f->num[0];
+  f->n--;
+  memmove(&(f->num[0]), &(f->num[1]), f->n * sizeof(int));
+  return r;
+}
+
+#define N_LIN_CONS ((N_LIN)-2-(N_TERM)*2)  // número de linhas pra console
+
+struct tela_t {
+  fila_de_numeros entrada[N_TERM];        // uma fila de entrada por terminal
+  fila_de_numeros saida[N_TERM];          // uma fila de saída por terminal
+  char txt_console[N_LIN_CONS][N_COL+1];  // texto das linhas da console
+  char *console;                          // onde escrever a console no fim
+};
+
+tela_t *t_inicio(char *console)
+{
+  tela_t *self = calloc(1, sizeof(*self));
+  if (self != NULL && console != NULL) {
+    self->console = strdup(console);
+  }
+  return self;
+}
+
+void t_fim(tela_t *self)
+{
+  FILE *arq = stdout;
+  if (self->console != NULL) {
+    arq = fopen(self->console, "w");
+  }
+  if (arq != NULL) {
+    for (int l=0; l<N_LIN_CONS; l++) {
+      if (self->txt_console[l][0] != '\0') {
+        fprintf(arq, "%s\n", self->txt_console[l]);
+      }
+    }
+    if (arq != stdout) fclose(arq);
+  }
+  free(self->console);
+  free(self);
+}
+
+bool t_livre(tela_t *self, int t)
+{
+  return true;
+}
+
+void t_print(tela_t *self, int t, int n)
+{
+  fn_ins(&self->saida[t], n);
+}
+
+bool t_tem(tela_t *self, int t)
+{
+  return self->entrada[t].n > 0;
+}
+
+int t_le(tela_t *self, int t)
+{
+  return fn_rem(&self->entrada[t]);
+}
+
+void t_ins(tela_t *self, int t, int n)
+{
+  fn_ins(&self->entrada[t], n);
+}
+
+static void insere_string_na_console(tela_t *self, char *s)
+{
+  memmove(self->txt_console[0], self->txt_console[1],
+          (N_LIN_CONS-1) * sizeof(self->txt_console[0]));
+  // a linha é cortada em N_COL caracteres, como na tela de verdade
+  snprintf(self->txt_console[N_LIN_CONS-1], N_COL+1, "%.*s", N_COL, s);
+}
+
+void t_status(tela_t *self, char *txt)
+{
+  // não tem onde mostrar
+}
+
+bool t_quer_status(tela_t *self)
+{
+  return false;
+}
+
+int t_printf(tela_t *self, char *formato, ...)
+{
+  char s[sizeof(self->txt_console)];
+  va_list arg;
+  va_start(arg, formato);
+  int r = vsnprintf(s, sizeof(s), formato, arg);
+  va_end(arg);
+  char *l = s;
+  while (*l != '\0') {
+    char *f = strchr(l, '\n');
+    if (f != NULL) {
+      *f = '\0';
+    }
+    insere_string_na_console(self, l);
+    if (f == NULL) break;
+    l = f+1;
+  }
+  return r;
+}
+
+bool t_passo_a_passo(tela_t *self)
+{
+  return false;
+}
+
+void t_atualiza(tela_t *self)
+{
+}
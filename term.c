@@ -7,12 +7,15 @@
 // TODO: implementar suporte a múltiplos terminais
 
 struct term_t {
-  // por enquanto não tem muito o que colocar aqui
+  tela_t *tela;  // onde estão os terminais
 };
 
-term_t *term_cria(void)
+term_t *term_cria(tela_t *tela)
 {
   term_t *self = malloc(sizeof(*self));
+  if (self != NULL) {
+    self->tela = tela;
+  }
   return self;
 }
 
@@ -24,24 +27,27 @@ void term_destroi(term_t *self)
 
 err_t term_le(void *disp, int id, int *pvalor)
 {
+  term_t *self = disp;
   if (!term_pronto(disp, id, leitura)) return ERR_OCUP;
-  *pvalor = t_le(id);
+  *pvalor = t_le(self->tela, id);
   return ERR_OK;
 }
 
 err_t term_escr(void *disp, int id, int valor)
 {
+  term_t *self = disp;
   if (!term_pronto(disp, id, escrita)) return ERR_OCUP;
-  t_print(id, valor);
+  t_print(self->tela, id, valor);
   return ERR_OK;
 }
 
 bool term_pronto(void *disp, int id, acesso_t acesso)
 {
+  term_t *self = disp;
   if (acesso == leitura) {
-    return t_tem(id);
+    return t_tem(self->tela, id);
   } else if (acesso == escrita) {
-    return t_livre(id);
+    return t_livre(self->tela, id);
   }
   return false;
 }
@@ -6,12 +6,13 @@
 // por enquanto só suporta um terminal
 
 #include "es.h"
+#include "tela.h"
 
 typedef struct term_t term_t;
 
-// cria e inicializa um terminal
+// cria e inicializa um terminal, que faz a entrada e saída na 'tela'
 // retorna NULL em caso de erro
-term_t *term_cria(void);
+term_t *term_cria(tela_t *tela);
 
 // destrói um terminal
 // nenhuma outra operação pode ser realizada no terminal após esta chamada
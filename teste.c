@@ -1,12 +1,117 @@
 #include "contr.h"
 #include "so.h"
+#include "config.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
 
-int main()
+static void uso(char *nome)
 {
-  contr_t *contr = contr_cria();
-  so_t *so = so_cria(contr);
+  config_t padrao;
+  config_padrao(&padrao);
+  fprintf(stderr, "uso: %s [-c arquivo] [-o chave=valor] [-m mem_tam] "
+                  "[-q quadro_tam] [-e motor] [-p algoritmo] [-l subst] "
+                  "[-t traço]\n", nome);
+  fprintf(stderr, "  -c  lê os parâmetros do arquivo, "
+                  "uma linha 'chave = valor' para cada\n");
+  fprintf(stderr, "  -o  altera um parâmetro; os parâmetros e seus valores "
+                  "padrão são:\n");
+  config_imprime(&padrao, stderr);
+  fprintf(stderr, "  -m, -q, -e, -p, -l  o mesmo que -o com mem_tam, "
+                  "quadro_tam, motor, alg_pag e subst\n");
+  fprintf(stderr, "  motor: switch encadeado jit\n");
+  fprintf(stderr, "  escalonador: round_robin shortest\n");
+  fprintf(stderr, "  alg_pag:");
+  for (int t = 0; t < N_ALG_PAG; t++) {
+    fprintf(stderr, " %s", alg_pag_nome(t));
+  }
+  fprintf(stderr, "\n");
+  fprintf(stderr, "  subst: global, ou local com cotas de quadros iguais, "
+                  "proporcionais ao programa\n"
+                  "         ou pela frequência de falhas "
+                  "(igual proporcional pff)\n");
+  fprintf(stderr, "  falpag_assincrona: nao sim (o processo espera o disco "
+                  "numa falha de página)\n");
+  fprintf(stderr, "  cota_min: menor cota de quadros na substituição local\n");
+  fprintf(stderr, "  controle_carga: nao sim (suspende processos quando a "
+                  "demanda estimada passa da memória)\n");
+  fprintf(stderr, "  janela_pff, pff_alta, pff_baixa, demanda_min: janela "
+                  "(em interrupções de relógio) e\n"
+                  "         limites de falhas da estimativa da demanda, e a "
+                  "menor demanda\n");
+  fprintf(stderr, "  limpeza: nao sim (copia antes as páginas alteradas "
+                  "que serão substituídas)\n");
+  fprintf(stderr, "  limpos_min: quadros livres ou limpos mantidos pela "
+                  "limpeza\n");
+  fprintf(stderr, "  prebusca_seq: páginas seguintes trazidas numa falha "
+                  "em acesso sequencial (0 desliga)\n");
+  fprintf(stderr, "  pre_paginacao: nao sim (o processo suspenso volta "
+                  "com as páginas que tinha)\n");
+  fprintf(stderr, "  compartilha: nao sim (páginas iguais não alteradas "
+                  "usam o mesmo quadro)\n");
+  fprintf(stderr, "  max_paginas: páginas do espaço de endereçamento de um "
+                  "processo\n");
+  fprintf(stderr, "  -t  grava as páginas referenciadas no arquivo 'traço', "
+                  "para o avalia_pag\n");
+}
+
+int main(int argc, char *argv[])
+{
+  config_t config;
+  config_padrao(&config);
+  FILE *traco = NULL;
+  bool ok = true;
+  int opt;
+  while (ok && (opt = getopt(argc, argv, "c:o:m:q:e:p:l:t:")) != -1) {
+    switch (opt) {
+      case 'c':
+        ok = config_le_arquivo(&config, optarg);
+        break;
+      case 'o':
+        ok = config_muda_par(&config, optarg);
+        break;
+      case 'm':
+        ok = config_muda(&config, "mem_tam", optarg);
+        break;
+      case 'q':
+        ok = config_muda(&config, "quadro_tam", optarg);
+        break;
+      case 'e':
+        ok = config_muda(&config, "motor", optarg);
+        break;
+      case 'p':
+        ok = config_muda(&config, "alg_pag", optarg);
+        break;
+      case 'l':
+        ok = config_muda(&config, "subst", optarg);
+        break;
+      case 't':
+        traco = fopen(optarg, "wb");
+        if (traco == NULL) {
+          perror(optarg);
+          return 1;
+        }
+        break;
+      default:
+        ok = false;
+    }
+  }
+  if (!ok) {
+    uso(argv[0]);
+    return 1;
+  }
+  char *erro = config_erro(&config);
+  if (erro != NULL) {
+    fprintf(stderr, "%s: configuração inválida: %s\n", argv[0], erro);
+    return 1;
+  }
+
+  contr_t *contr = contr_cria(&config);
+  if (traco != NULL) mmu_grava_traco(contr_mmu(contr), traco);
+  so_t *so = so_cria(contr, &config);
   contr_informa_so(contr, so);
   contr_laco(contr);
   contr_destroi(contr);
+  if (traco != NULL) fclose(traco);
   return 0;
 }
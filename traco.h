@@ -0,0 +1,48 @@
+#ifndef TRACO_H
+#define TRACO_H
+
+// formato do traço de referências à memória gravado pela MMU (ver
+//   mmu_grava_traco) e lido pelo avaliador de algoritmos de substituição
+//   de páginas (avalia_pag)
+// o arquivo começa com um cabeçalho, seguido de um registro para cada
+//   referência a uma página; referências seguidas à mesma página pelo
+//   mesmo processo não são repetidas (uma escrita depois de uma leitura é)
+// os valores são gravados na ordem de bytes da máquina
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define TRACO_MAGICO 0x43415254  // "TRAC"
+
+typedef struct {
+  uint32_t magico;   // TRACO_MAGICO
+  uint32_t tam_pag;  // tamanho das páginas, em palavras
+} traco_cab_t;
+
+// um registro tem o espaço de endereçamento (o pid) nos 16 bits mais
+//   significativos, a página nos 15 seguintes e no bit menos significativo
+//   se o acesso foi uma escrita
+typedef uint32_t traco_reg_t;
+
+static inline traco_reg_t traco_reg(int asid, int pagina, bool escrita)
+{
+  return ((uint32_t)asid << 16) | (((uint32_t)pagina & 0x7fff) << 1)
+         | (escrita ? 1 : 0);
+}
+
+static inline int traco_asid(traco_reg_t reg)
+{
+  return reg >> 16;
+}
+
+static inline int traco_pagina(traco_reg_t reg)
+{
+  return (reg >> 1) & 0x7fff;
+}
+
+static inline bool traco_escrita(traco_reg_t reg)
+{
+  return reg & 1;
+}
+
+#endif // TRACO_H
@@ -0,0 +1,258 @@
+// varredura
+// executa a simulação para várias configurações, em paralelo
+// as configurações são descritas como no arquivo de configuração do teste
+//   (config.h), mas cada parâmetro pode ter vários valores, separados por
+//   espaço; são executadas todas as combinações dos valores
+//   ex.: "alg_pag = fifo relogio" e "mem_tam = 300 800" são 4 execuções
+// cada execução é uma máquina independente (controlador e SO próprios, com
+//   a tela sem interface), executada por uma das threads; os resultados
+//   de cada uma ficam em um diretório próprio: a configuração usada
+//   (config.txt), as métricas (so.txt e proc-*.txt) e a console
+//   (console.txt)
+
+#include "contr.h"
+#include "so.h"
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+#define MAX_PARAMS 20   // parâmetros que podem variar
+#define MAX_VALORES 20  // valores de cada parâmetro
+#define MAX_THREADS 256
+
+// um parâmetro e os valores que ele assume
+typedef struct {
+  char *chave;
+  int n_valores;
+  char *valores[MAX_VALORES];
+} param_t;
+
+// a varredura, compartilhada pelas threads
+typedef struct {
+  config_t base;             // a configuração com os parâmetros fixos
+  param_t params[MAX_PARAMS];// os parâmetros com mais de um valor
+  int n_params;
+  int n_execucoes;           // número de combinações dos valores
+  char *dir;                 // onde ficam os diretórios das execuções
+  pthread_mutex_t mutex;     // protege o que vem abaixo e a saída padrão
+  int proxima;               // próxima execução a ser feita
+  int feitas;                // execuções terminadas
+  int erros;                 // execuções com configuração inválida
+} varredura_t;
+
+// acrescenta os valores do parâmetro descrito em "chave = v1 v2 ..."
+// retorna false se a descrição não for válida
+static bool le_param(varredura_t *self, char *linha)
+{
+  char *igual = strchr(linha, '=');
+  if (igual == NULL) return false;
+  *igual = '\0';
+  char *chave = strtok(linha, " \t\r\n");
+  if (chave == NULL || strtok(NULL, " \t\r\n") != NULL) return false;
+  char *valores[MAX_VALORES];
+  int n = 0;
+  for (char *v = strtok(igual + 1, " \t\r\n"); v != NULL;
+       v = strtok(NULL, " \t\r\n")) {
+    // cada valor é verificado agora, para não descobrir o erro no meio
+    config_t teste = self->base;
+    if (n == MAX_VALORES || !config_muda(&teste, chave, v)) return false;
+    valores[n++] = v;
+  }
+  if (n == 0) return false;
+  if (n == 1) {
+    config_muda(&self->base, chave, valores[0]);
+    return true;
+  }
+  if (self->n_params == MAX_PARAMS) return false;
+  param_t *p = &self->params[self->n_params++];
+  p->chave = strdup(chave);
+  p->n_valores = n;
+  for (int i = 0; i < n; i++) {
+    p->valores[i] = strdup(valores[i]);
+  }
+  return true;
+}
+
+// lê os parâmetros do arquivo 'nome', uma linha para cada
+static bool le_arquivo(varredura_t *self, char *nome)
+{
+  FILE *arq = fopen(nome, "r");
+  if (arq == NULL) {
+    perror(nome);
+    return false;
+  }
+  char linha[1000];
+  int n_linha = 0;
+  bool ok = true;
+  while (ok && fgets(linha, sizeof(linha), arq) != NULL) {
+    n_linha++;
+    char *comentario = strchr(linha, '#');
+    if (comentario != NULL) *comentario = '\0';
+    if (strspn(linha, " \t\r\n") == strlen(linha)) continue;
+    if (!le_param(self, linha)) {
+      fprintf(stderr, "%s:%d: parâmetro inválido\n", nome, n_linha);
+      ok = false;
+    }
+  }
+  fclose(arq);
+  return ok;
+}
+
+// monta a configuração da execução 'n': os valores dos parâmetros são os
+//   dígitos de 'n', com o último parâmetro variando mais rápido
+// coloca em 'desc' os valores usados
+static void monta_config(varredura_t *self, int n, config_t *config,
+                         char *desc, int tam_desc)
+{
+  *config = self->base;
+  desc[0] = '\0';
+  for (int p = self->n_params - 1; p >= 0; p--) {
+    param_t *param = &self->params[p];
+    char *valor = param->valores[n % param->n_valores];
+    n /= param->n_valores;
+    config_muda(config, param->chave, valor);
+    char aux[200];
+    snprintf(aux, sizeof(aux), " %s=%s%s", param->chave, valor, desc);
+    snprintf(desc, tam_desc, "%s", aux);
+  }
+}
+
+// executa a simulação 'n', com os resultados no seu diretório
+static void executa(varredura_t *self, int n)
+{
+  config_t config;
+  char desc[200];
+  monta_config(self, n, &config, desc, sizeof(desc));
+  // o nome do diretório deixa espaço para o nome dos arquivos
+  char dir[CONFIG_NOME_TAM - 20];
+  snprintf(dir, sizeof(dir), "%s/%03d", self->dir, n);
+  snprintf(config.metricas, sizeof(config.metricas), "%s", dir);
+  snprintf(config.console, sizeof(config.console), "%s/console.txt", dir);
+
+  char *erro = config_erro(&config);
+  if (erro == NULL && mkdir(dir, 0777) != 0 && errno != EEXIST) {
+    erro = "não foi possível criar o diretório";
+  }
+  time_t inicio = time(NULL);
+  if (erro == NULL) {
+    char nome[CONFIG_NOME_TAM + 20];
+    snprintf(nome, sizeof(nome), "%s/config.txt", dir);
+    FILE *arq = fopen(nome, "w");
+    if (arq != NULL) {
+      config_imprime(&config, arq);
+      fclose(arq);
+    }
+    contr_t *contr = contr_cria(&config);
+    so_t *so = so_cria(contr, &config);
+    contr_informa_so(contr, so);
+    contr_laco(contr);
+    so_destroi(so);
+    contr_destroi(contr);
+  }
+
+  pthread_mutex_lock(&self->mutex);
+  self->feitas++;
+  if (erro != NULL) {
+    self->erros++;
+    printf("[%d/%d] %s:%s: %s\n", self->feitas, self->n_execucoes, dir, desc,
+           erro);
+  } else {
+    printf("[%d/%d] %s:%s (%.0fs)\n", self->feitas, self->n_execucoes, dir,
+           desc, difftime(time(NULL), inicio));
+  }
+  fflush(stdout);
+  pthread_mutex_unlock(&self->mutex);
+}
+
+// cada thread executa as próximas simulações, até acabarem
+static void *trabalha(void *arg)
+{
+  varredura_t *self = arg;
+  for (;;) {
+    pthread_mutex_lock(&self->mutex);
+    int n = self->proxima++;
+    pthread_mutex_unlock(&self->mutex);
+    if (n >= self->n_execucoes) break;
+    executa(self, n);
+  }
+  return NULL;
+}
+
+static void uso(char *nome)
+{
+  fprintf(stderr, "uso: %s [-j threads] [-d diretório] [-o 'chave=valores'] "
+                  "[arquivo]\n", nome);
+  fprintf(stderr, "  -j  número de simulações executadas ao mesmo tempo "
+                  "(padrão: número de processadores)\n");
+  fprintf(stderr, "  -d  onde criar o diretório de cada simulação "
+                  "(padrão: varredura)\n");
+  fprintf(stderr, "  -o  valores de um parâmetro, separados por espaço\n");
+  fprintf(stderr, "  o arquivo tem uma linha 'chave = valores' para cada "
+                  "parâmetro; os parâmetros são os do teste:\n");
+  config_t padrao;
+  config_padrao(&padrao);
+  config_imprime(&padrao, stderr);
+}
+
+int main(int argc, char *argv[])
+{
+  static varredura_t varredura;
+  varredura_t *self = &varredura;
+  config_padrao(&self->base);
+  self->dir = "varredura";
+  pthread_mutex_init(&self->mutex, NULL);
+  int n_threads = sysconf(_SC_NPROCESSORS_ONLN);
+  int opt;
+  while ((opt = getopt(argc, argv, "j:d:o:")) != -1) {
+    switch (opt) {
+      case 'j':
+        n_threads = atoi(optarg);
+        break;
+      case 'd':
+        self->dir = optarg;
+        break;
+      case 'o':
+        if (!le_param(self, optarg)) {
+          fprintf(stderr, "parâmetro inválido: %s\n", optarg);
+          return 1;
+        }
+        break;
+      default:
+        uso(argv[0]);
+        return 1;
+    }
+  }
+  for (int i = optind; i < argc; i++) {
+    if (!le_arquivo(self, argv[i])) return 1;
+  }
+  if (n_threads < 1) n_threads = 1;
+  if (n_threads > MAX_THREADS) n_threads = MAX_THREADS;
+  if (mkdir(self->dir, 0777) != 0 && errno != EEXIST) {
+    perror(self->dir);
+    return 1;
+  }
+
+  self->n_execucoes = 1;
+  for (int p = 0; p < self->n_params; p++) {
+    self->n_execucoes *= self->params[p].n_valores;
+  }
+  if (n_threads > self->n_execucoes) n_threads = self->n_execucoes;
+  printf("%d simulações, %d threads, resultados em %s/\n",
+         self->n_execucoes, n_threads, self->dir);
+
+  pthread_t threads[MAX_THREADS];
+  for (int t = 0; t < n_threads; t++) {
+    pthread_create(&threads[t], NULL, trabalha, self);
+  }
+  for (int t = 0; t < n_threads; t++) {
+    pthread_join(threads[t], NULL);
+  }
+  pthread_mutex_destroy(&self->mutex);
+  return self->erros == 0 ? 0 : 1;
+}